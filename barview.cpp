@@ -0,0 +1,226 @@
+#include "barview.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <algorithm>
+#include <cmath>
+
+BarView::BarView(QWidget *parent) : QWidget(parent)
+{
+    // The cached image covers the whole widget, no need to erase behind it
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    m_ownerRgb[0] = 0;
+    for (int owner = 1; owner < 256; ++owner) {
+        // Spread neighbouring thread numbers around the hue circle
+        m_ownerRgb[owner] = QColor::fromHsv((owner - 1) * 67 % 360, 170, 230).rgb();
+    }
+}
+
+int BarView::gridColumns(int count)
+{
+    return count <= 1 ? 1 : int(std::ceil(std::sqrt(double(count))));
+}
+
+void BarView::setPanelCount(int count)
+{
+    m_panels.resize(qMax(0, count));
+    // Every panel moves when the grid changes shape
+    for (Panel &panel : m_panels) {
+        panel.dirty = true;
+    }
+    m_cache = QImage();
+    update();
+}
+
+void BarView::setValues(int panel, const QVector<int> &values)
+{
+    m_panels[panel].values = values; // Implicitly shared, no copy until the owner modifies its array
+    markDirty(panel);
+}
+
+void BarView::setHighlights(int panel, const QVector<int> &indices)
+{
+    m_panels[panel].highlights = indices;
+    markDirty(panel);
+}
+
+void BarView::setOwners(int panel, const QVector<quint8> &owners)
+{
+    m_panels[panel].owners = owners;
+    markDirty(panel);
+}
+
+void BarView::setTitle(int panel, const QString &title)
+{
+    m_panels[panel].title = title;
+    update(panelRect(panel));
+}
+
+void BarView::setOverlay(int panel, const QString &text)
+{
+    // The text sits on top of the bars, which have to be drawn again underneath it
+    m_panels[panel].overlay = text;
+    markDirty(panel);
+}
+
+void BarView::setBarColor(int panel, const QColor &color)
+{
+    m_panels[panel].barColor = color;
+    markDirty(panel);
+}
+
+void BarView::clear(int panel)
+{
+    Panel &cleared = m_panels[panel];
+    cleared.values.clear();
+    cleared.highlights.clear();
+    cleared.owners.clear();
+    cleared.overlay.clear();
+    cleared.barColor = Qt::blue;
+    markDirty(panel);
+}
+
+void BarView::markDirty(int panel)
+{
+    m_panels[panel].dirty = true;
+    // Only the panel's area is invalidated; Qt merges all of them into the next paint event
+    update(panelRect(panel));
+}
+
+QRect BarView::panelRect(int panel) const
+{
+    const int count = int(m_panels.size());
+    const int columns = gridColumns(count);
+    const int rows = qMax(1, (count + columns - 1) / columns);
+    const int cellWidth = qMax(1, (width() - (columns - 1) * PanelSpacing) / columns);
+    const int cellHeight = qMax(1, (height() - (rows - 1) * PanelSpacing) / rows);
+    return QRect(panel % columns * (cellWidth + PanelSpacing), panel / columns * (cellHeight + PanelSpacing),
+                 cellWidth, cellHeight);
+}
+
+void BarView::resizeEvent(QResizeEvent *event)
+{
+    for (Panel &panel : m_panels) {
+        panel.dirty = true;
+    }
+    QWidget::resizeEvent(event);
+}
+
+void BarView::paintEvent(QPaintEvent *event)
+{
+    if (m_cache.size() != size()) {
+        m_cache = QImage(qMax(1, width()), qMax(1, height()), QImage::Format_RGB32);
+        m_cache.fill(palette().color(QPalette::Window));
+    }
+
+    // One pass over the panels that changed since the last frame
+    for (int i = 0; i < m_panels.size(); ++i) {
+        if (m_panels[i].dirty) {
+            renderBars(m_panels[i], panelRect(i).adjusted(0, TitleHeight, 0, 0));
+            m_panels[i].dirty = false;
+        }
+    }
+
+    QPainter painter(this);
+    painter.drawImage(event->rect(), m_cache, event->rect());
+
+    if (m_panels.isEmpty()) {
+        painter.drawText(rect(), Qt::AlignCenter, "Add an algorithm");
+        return;
+    }
+
+    for (int i = 0; i < m_panels.size(); ++i) {
+        const QRect rect = panelRect(i);
+        if (!event->rect().intersects(rect)) {
+            continue;
+        }
+        const Panel &panel = m_panels[i];
+        painter.drawText(QRect(rect.left(), rect.top(), rect.width(), TitleHeight), Qt::AlignCenter, panel.title);
+
+        if (!panel.overlay.isEmpty()) {
+            const QRect bars = rect.adjusted(2, TitleHeight + 2, -2, -2);
+            const QRect text = painter.boundingRect(bars, Qt::AlignLeft | Qt::AlignTop, panel.overlay);
+            painter.fillRect(text.adjusted(-2, -2, 2, 2), QColor(255, 255, 255, 200));
+            painter.drawText(bars, Qt::AlignLeft | Qt::AlignTop, panel.overlay);
+        }
+    }
+}
+
+void BarView::renderBars(Panel &panel, const QRect &rect)
+{
+    // Title strip and background, the title text itself is drawn over the image
+    const QRect area = rect.adjusted(0, -TitleHeight, 0, 0).intersected(m_cache.rect());
+    const QRgb background = palette().color(QPalette::Window).rgb();
+    for (int y = area.top(); y <= area.bottom(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(m_cache.scanLine(y));
+        std::fill(line + area.left(), line + area.left() + area.width(), background);
+    }
+
+    const QRect bars = rect.intersected(m_cache.rect());
+    const int imageWidth = bars.width();
+    const int imageHeight = bars.height();
+    const int n = panel.values.size();
+    if (n == 0 || imageWidth <= 0 || imageHeight <= 0) {
+        return;
+    }
+
+    // Bars start at zero like the QtCharts axis, negative values extend the range down
+    const auto [minIt, maxIt] = std::minmax_element(panel.values.cbegin(), panel.values.cend());
+    const qint64 low = qMin(0, *minIt);
+    const qint64 range = qMax<qint64>(1, qint64(*maxIt) - low);
+
+    // Reduce the array to one height per pixel column (tallest bar wins when bars share a column)
+    panel.columnHeights.fill(0, imageWidth);
+    panel.columnHighlighted.fill(0, imageWidth);
+    panel.columnOwners.fill(0, imageWidth);
+    int *heights = panel.columnHeights.data();
+    quint8 *highlighted = panel.columnHighlighted.data();
+    quint8 *columnOwners = panel.columnOwners.data();
+    const int *values = panel.values.constData();
+    const quint8 *owners = panel.owners.size() == n ? panel.owners.constData() : nullptr;
+
+    const bool gaps = imageWidth >= 3 * n; // Leave a 1px gap between wide bars
+    for (int i = 0; i < n; ++i) {
+        const int x0 = int(qint64(i) * imageWidth / n);
+        int x1 = qMax(x0 + 1, int(qint64(i + 1) * imageWidth / n));
+        if (gaps) {
+            x1--;
+        }
+        const int h = int((values[i] - low) * imageHeight / range);
+        for (int x = x0; x < x1; ++x) {
+            if (h >= heights[x]) {
+                heights[x] = h;
+                if (owners) {
+                    columnOwners[x] = owners[i];
+                }
+            }
+        }
+    }
+
+    for (int index : std::as_const(panel.highlights)) {
+        if (index < 0 || index >= n) {
+            continue;
+        }
+        const int x0 = int(qint64(index) * imageWidth / n);
+        const int x1 = qMax(x0 + 1, int(qint64(index + 1) * imageWidth / n));
+        for (int x = x0; x < x1; ++x) {
+            highlighted[x] = 1;
+        }
+    }
+
+    // Rasterize row by row straight into the panel's part of the image memory
+    const QRgb highlightRgb = m_highlightColor.rgb();
+    QRgb columnRgb[256];
+    std::copy(m_ownerRgb, m_ownerRgb + 256, columnRgb);
+    columnRgb[0] = panel.barColor.rgb();
+    for (int y = 0; y < imageHeight; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(m_cache.scanLine(bars.top() + y)) + bars.left();
+        const int threshold = imageHeight - y;
+        for (int x = 0; x < imageWidth; ++x) {
+            if (heights[x] >= threshold) {
+                line[x] = highlighted[x] ? highlightRgb : columnRgb[columnOwners[x]];
+            }
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef BARVIEW_H
+#define BARVIEW_H
+
+#include <QWidget>
+#include <QVector>
+#include <QImage>
+#include <QColor>
+#include <QString>
+
+// Lightweight bar charts that draw each array in one pass into a cached image.
+// Used instead of QChartView when the array is too large for QBarSeries or there are too many
+// charts for a view each. Every chart is a panel of this one widget: a frame rasterizes the
+// panels whose data changed into one shared image and paints it once, however many charts there are.
+class BarView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit BarView(QWidget *parent = nullptr);
+
+    // Panels are laid out row by row in gridColumns(count) columns
+    void setPanelCount(int count);
+    int panelCount() const { return int(m_panels.size()); }
+    static int gridColumns(int count);
+
+    void setValues(int panel, const QVector<int> &values);
+    void setHighlights(int panel, const QVector<int> &indices);
+    void setOwners(int panel, const QVector<quint8> &owners); // Per element pool thread + 1, 0 uses the bar color
+    void setTitle(int panel, const QString &title);
+    void setOverlay(int panel, const QString &text); // Drawn over the top left corner of the bars
+    void setBarColor(int panel, const QColor &color);
+    void clear(int panel);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    struct Panel
+    {
+        QVector<int> values;
+        QVector<int> highlights;
+        QVector<quint8> owners;
+        QString title;
+        QString overlay;
+        QColor barColor = Qt::blue;
+        bool dirty = true;
+
+        // Per pixel column reduction of the array, kept to avoid reallocating every frame
+        QVector<int> columnHeights;
+        QVector<quint8> columnHighlighted;
+        QVector<quint8> columnOwners;
+    };
+
+    QVector<Panel> m_panels;
+    QColor m_highlightColor = Qt::red;
+    QRgb m_ownerRgb[256]; // Bar colour per owner, 0 is replaced by the panel's bar colour
+
+    // Bars of all panels are rasterized here and each panel is only redrawn when its data changes
+    QImage m_cache;
+    static constexpr int TitleHeight = 20;
+    static constexpr int PanelSpacing = 6;
+
+    QRect panelRect(int panel) const;
+    void markDirty(int panel);
+    void renderBars(Panel &panel, const QRect &rect);
+};
+
+#endif // BARVIEW_H
@@ -0,0 +1,374 @@
+#include "benchmark.h"
+#include "sortalgorithms.h"
+#include "sortelements.h"
+#include "datagenerator.h"
+#include "workstealingpool.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <cstring>
+#include <thread>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+struct BenchmarkResult
+{
+    QString algorithm;
+    QString distribution;
+    QString elementType;
+    int size = 0;
+    int threads = 1;
+    double nsPerElement = 0.0;
+    double speedup = 1.0; // Against the same algorithm on the fewest threads measured
+    qint64 comparisons = 0;
+    qint64 swaps = 0;
+    qint64 writes = 0;
+    qint64 cacheMisses = 0; // Simulated 32 KB cache, see sorting::detail::CacheModel
+    qint64 auxMemoryKb = 0; // Peak scratch memory the algorithm took from its arena
+    qint64 peakMemoryKb = 0;
+    bool sorted = false;
+};
+
+// Peak resident set size of the whole process, in kilobytes
+qint64 peakMemoryKb()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss; // Kilobytes on Linux
+    }
+#endif
+    return 0;
+}
+
+void writeCsv(QTextStream &out, const QVector<BenchmarkResult> &results)
+{
+    out << "algorithm,distribution,element_type,size,threads,ns_per_element,speedup,comparisons,swaps,writes,cache_misses,aux_memory_kb,peak_memory_kb,sorted\n";
+    for (const BenchmarkResult &result : results) {
+        out << '"' << result.algorithm << "\","
+            << result.distribution << ','
+            << result.elementType << ','
+            << result.size << ','
+            << result.threads << ','
+            << QString::number(result.nsPerElement, 'f', 3) << ','
+            << QString::number(result.speedup, 'f', 3) << ','
+            << result.comparisons << ','
+            << result.swaps << ','
+            << result.writes << ','
+            << result.cacheMisses << ','
+            << result.auxMemoryKb << ','
+            << result.peakMemoryKb << ','
+            << (result.sorted ? "true" : "false") << '\n';
+    }
+}
+
+void writeJson(QTextStream &out, const QVector<BenchmarkResult> &results)
+{
+    QJsonArray array;
+    for (const BenchmarkResult &result : results) {
+        QJsonObject object;
+        object["algorithm"] = result.algorithm;
+        object["distribution"] = result.distribution;
+        object["element_type"] = result.elementType;
+        object["size"] = result.size;
+        object["threads"] = result.threads;
+        object["ns_per_element"] = result.nsPerElement;
+        object["speedup"] = result.speedup;
+        object["comparisons"] = result.comparisons;
+        object["swaps"] = result.swaps;
+        object["writes"] = result.writes;
+        object["cache_misses"] = result.cacheMisses;
+        object["aux_memory_kb"] = result.auxMemoryKb;
+        object["peak_memory_kb"] = result.peakMemoryKb;
+        object["sorted"] = result.sorted;
+        array.append(object);
+    }
+    out << QJsonDocument(array).toJson(QJsonDocument::Indented);
+}
+
+// Times repeat runs of algorithm on copies of input and collects the operation counts of one
+// more, untimed run. Returns the fastest run in nanoseconds.
+template <typename T>
+qint64 measure(SortAlgorithm algorithm, const std::vector<T> &input, int repeat, WorkStealingPool *pool,
+               BenchmarkResult &result)
+{
+    const int size = int(input.size());
+
+    // Timed runs use the no-op observer, so they measure the bare algorithm
+    qint64 bestNs = -1;
+    for (int run = 0; run < repeat; ++run) {
+        std::vector<T> data = input; // Copied before the clock starts
+        sorting::NullObserver observer;
+
+        QElapsedTimer elapsed;
+        elapsed.start();
+        runSortAlgorithm(algorithm, data.data(), size, observer, pool);
+        const qint64 ns = elapsed.nsecsElapsed();
+
+        if (bestNs < 0 || ns < bestNs) {
+            bestNs = ns;
+        }
+        result.sorted = std::is_sorted(data.cbegin(), data.cend());
+    }
+
+    // The cache model counts lines of sizeof(T) elements, so wider types miss more often
+    std::vector<T> data = input;
+    sorting::CountingObserver counter(sizeof(T));
+    sorting::SortArena::threadLocal().resetPeak();
+    runSortAlgorithm(algorithm, data.data(), size, counter, pool);
+    result.auxMemoryKb = qint64(sorting::SortArena::threadLocal().peakUsage() / 1024);
+    result.comparisons = counter.comparisons;
+    result.swaps = counter.swaps;
+    result.writes = counter.writes;
+    result.cacheMisses = counter.cacheMisses;
+    return bestNs;
+}
+
+} // namespace
+
+bool isBenchmarkInvocation(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--benchmark") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int runBenchmark(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs the sorting algorithms without the GUI and reports timings.");
+    parser.addHelpOption();
+    parser.addOption({"benchmark", "Run the headless benchmark."});
+    parser.addOption({"sizes", "Comma separated input sizes.", "sizes", "1000,10000"});
+    parser.addOption({"distributions", QString("Comma separated: %1.").arg(DataGenerator::distributionNames().join(", ")),
+                      "distributions", "random"});
+    parser.addOption({"input", "Sort the values of a raw int32 file instead of generated data.", "file"});
+    parser.addOption({"algorithms", "Comma separated algorithm names (default: all).", "algorithms"});
+    parser.addOption({"types", "Comma separated element types: int32, int64, float, double, record (16 bytes) or record64 (64 bytes).",
+                      "types", "int32"});
+    parser.addOption({"repeat", "Runs per measurement, the fastest is reported.", "count", "3"});
+    parser.addOption({"threads", "Comma separated thread counts for the parallel algorithms (default: 1 up to all cores, doubling).",
+                      "counts"});
+    parser.addOption({"isa", "Highest instruction set for the vectorized sorts: avx2, sse2 or scalar (default: best supported).",
+                      "isa"});
+    parser.addOption({"seed", "Seed for input generation.", "seed", "42"});
+    parser.addOption({"format", "Output format: csv or json.", "format", "csv"});
+    parser.addOption({"output", "Write results to a file instead of stdout.", "file"});
+    parser.process(arguments);
+
+    QVector<SortAlgorithm> algorithms;
+    if (parser.isSet("algorithms")) {
+        const QStringList requested = parser.value("algorithms").split(',', Qt::SkipEmptyParts);
+        for (const QString &name : requested) {
+            const int index = findSortAlgorithm(name.trimmed());
+            if (index < 0) {
+                qWarning() << "Unknown algorithm:" << name.trimmed() << "- available:" << sortAlgorithmNames().join(", ");
+                return 1;
+            }
+            algorithms << SortAlgorithm(index);
+        }
+    }
+    else {
+        for (int i = 0; i < sortAlgorithmCount(); ++i) {
+            algorithms << SortAlgorithm(i);
+        }
+    }
+
+    QVector<sorting::ElementType> elementTypes;
+    const QStringList typeList = parser.value("types").split(',', Qt::SkipEmptyParts);
+    for (const QString &name : typeList) {
+        const int index = sorting::findElementType(name.trimmed().toLatin1().constData());
+        if (index < 0) {
+            qWarning() << "Unknown element type:" << name.trimmed();
+            return 1;
+        }
+        elementTypes << sorting::ElementType(index);
+    }
+
+    QVector<int> sizes;
+    const QStringList sizeList = parser.value("sizes").split(',', Qt::SkipEmptyParts);
+    for (const QString &text : sizeList) {
+        bool ok = false;
+        int size = text.trimmed().toInt(&ok);
+        if (!ok || size <= 0 || size > DataGenerator::MaxSize) {
+            qWarning() << "Invalid size:" << text;
+            return 1;
+        }
+        sizes << size;
+    }
+
+    QVector<int> threadCounts;
+    if (parser.isSet("threads")) {
+        const QStringList threadList = parser.value("threads").split(',', Qt::SkipEmptyParts);
+        for (const QString &text : threadList) {
+            bool ok = false;
+            int count = text.trimmed().toInt(&ok);
+            if (!ok || count <= 0) {
+                qWarning() << "Invalid thread count:" << text;
+                return 1;
+            }
+            threadCounts << count;
+        }
+    }
+    else {
+        const int cores = qMax(1, int(std::thread::hardware_concurrency()));
+        for (int count = 1; count < cores; count *= 2) {
+            threadCounts << count;
+        }
+        threadCounts << cores;
+    }
+    std::sort(threadCounts.begin(), threadCounts.end());
+    threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+    const QString format = parser.value("format");
+    if (format != "csv" && format != "json") {
+        qWarning() << "Unknown format:" << format << "- available: csv, json";
+        return 1;
+    }
+
+    // Opened before measuring, so a bad path fails now rather than after the whole sweep
+    QFile file;
+    if (parser.isSet("output")) {
+        file.setFileName(parser.value("output"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qWarning() << "Cannot open" << file.fileName();
+            return 1;
+        }
+    }
+    else {
+        file.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    }
+
+    // One pool per thread count, created up front so thread start-up is not timed
+    std::map<int, std::unique_ptr<WorkStealingPool>> pools;
+    for (int count : std::as_const(threadCounts)) {
+        pools[count] = std::make_unique<WorkStealingPool>(count);
+    }
+
+    if (parser.isSet("isa")) {
+        const QString isa = parser.value("isa");
+        if (isa == "avx2") {
+            sorting::simd::setActiveIsa(sorting::simd::Isa::Avx2);
+        }
+        else if (isa == "sse2") {
+            sorting::simd::setActiveIsa(sorting::simd::Isa::Sse2);
+        }
+        else if (isa == "scalar") {
+            sorting::simd::setActiveIsa(sorting::simd::Isa::Scalar);
+        }
+        else {
+            qWarning() << "Unknown instruction set:" << isa;
+            return 1;
+        }
+    }
+    qInfo().noquote() << "Vectorized sorts use" << sorting::simd::isaName(sorting::simd::activeIsa());
+
+    QStringList distributions;
+    QVector<int> fileInput;
+    if (parser.isSet("input")) {
+        QString error;
+        fileInput = DataGenerator::loadRaw(parser.value("input"), &error);
+        if (fileInput.isEmpty()) {
+            qWarning().noquote() << error;
+            return 1;
+        }
+        // The file is the only input, reported under its name
+        distributions << QFileInfo(parser.value("input")).fileName();
+        sizes = {int(fileInput.size())};
+    }
+    else {
+        const QStringList names = parser.value("distributions").split(',', Qt::SkipEmptyParts);
+        for (const QString &name : names) {
+            if (DataGenerator::findDistribution(name.trimmed()) < 0) {
+                qWarning() << "Unknown distribution:" << name.trimmed() << "- available:" << DataGenerator::distributionNames().join(", ");
+                return 1;
+            }
+            distributions << name.trimmed();
+        }
+    }
+    const int repeat = qMax(1, parser.value("repeat").toInt());
+    const quint64 seed = parser.value("seed").toULongLong();
+
+    QVector<BenchmarkResult> results;
+    for (const QString &distribution : distributions) {
+        for (int size : std::as_const(sizes)) {
+            // Every algorithm sorts the same input, like the GUI's shared vector
+            const QVector<int> input = fileInput.isEmpty()
+                ? DataGenerator::generate(DataDistribution(DataGenerator::findDistribution(distribution)), size, seed)
+                : fileInput;
+
+            for (sorting::ElementType elementType : std::as_const(elementTypes)) {
+                sorting::visitElementType(elementType, [&](auto tag) {
+                    using T = typename decltype(tag)::Type;
+
+                    // Built from the values the same way the GUI's workers do
+                    std::vector<T> typedInput(input.size());
+                    for (int i = 0; i < int(input.size()); ++i) {
+                        typedInput[i] = sorting::ElementTraits<T>::makeElement(input[i], i);
+                    }
+
+                    for (SortAlgorithm algorithm : std::as_const(algorithms)) {
+                        const SortAlgorithmInfo &info = sortAlgorithmInfo(algorithm);
+
+                        // Sequential algorithms run once, parallel ones once per thread count
+                        const QVector<int> runThreads = info.parallel ? threadCounts : QVector<int>{1};
+                        double baselineNs = 0.0;
+
+                        for (int threads : runThreads) {
+                            // Sequential algorithms ignore the pool
+                            WorkStealingPool *pool = pools[info.parallel ? threads : threadCounts.first()].get();
+
+                            BenchmarkResult result;
+                            result.algorithm = info.name;
+                            result.distribution = distribution;
+                            result.elementType = sorting::elementTypeInfo(elementType).name;
+                            result.size = size;
+                            result.threads = threads;
+
+                            const qint64 bestNs = measure(algorithm, typedInput, repeat, pool, result);
+                            result.nsPerElement = double(bestNs) / size;
+                            if (baselineNs == 0.0) {
+                                baselineNs = result.nsPerElement;
+                            }
+                            result.speedup = result.nsPerElement > 0.0 ? baselineNs / result.nsPerElement : 1.0;
+                            result.peakMemoryKb = peakMemoryKb();
+                            results << result;
+
+                            qInfo().noquote() << QString("%1 / %2 / %3 / %4 / %5 threads: %6 ns/element (%7x)")
+                                                     .arg(result.algorithm, result.distribution, result.elementType)
+                                                     .arg(size)
+                                                     .arg(result.threads)
+                                                     .arg(result.nsPerElement, 0, 'f', 2)
+                                                     .arg(result.speedup, 0, 'f', 2);
+                        }
+                    }
+                });
+            }
+        }
+    }
+
+    QTextStream out(&file);
+    if (format == "json") {
+        writeJson(out, results);
+    }
+    else {
+        writeCsv(out, results);
+    }
+    return 0;
+}
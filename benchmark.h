@@ -0,0 +1,14 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QStringList>
+
+// Headless benchmark entry point.
+// Started with: <app> --benchmark [--sizes 1000,10000] [--distributions random,sorted]
+//               [--algorithms "Quick Sort,Heap Sort"] [--types int32,int64,record]
+//               [--repeat 3] [--seed 42]
+//               [--input data.bin] [--format csv|json] [--output file]
+bool isBenchmarkInvocation(int argc, char *argv[]);
+int runBenchmark(const QStringList &arguments);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,278 @@
+#include "datagenerator.h"
+#include "workstealingpool.h"
+#include <QFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+
+const char *const DistributionNames[] = {
+    "random", "uniform", "sorted", "reversed", "nearly-sorted", "few-unique", "organ-pipe", "zipf", "gaussian"
+};
+static_assert(int(std::size(DistributionNames)) == int(DataDistribution::Count),
+              "DistributionNames must name every DataDistribution");
+
+// Elements per chunk; also the unit that owns one random stream
+const int ChunkSize = 1 << 16;
+const int FewUniqueValues = 8;
+
+quint64 mix64(quint64 z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// SplitMix64: small, fast and good enough for test data, with the same output on every platform
+class Random
+{
+public:
+    explicit Random(quint64 seed) : m_state(seed) {}
+
+    quint64 next()
+    {
+        m_state += 0x9E3779B97F4A7C15ull;
+        return mix64(m_state);
+    }
+
+    // Uniform in [0, bound), bound <= 2^32 (multiply-shift, no division)
+    quint32 below(quint32 bound) { return quint32((quint64(quint32(next())) * bound) >> 32); }
+
+    // Uniform in [0, 1)
+    double unit() { return double(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    quint64 m_state;
+};
+
+// Independent stream for one chunk of one array
+Random chunkRandom(quint64 seed, int chunk)
+{
+    return Random(mix64(seed ^ mix64(quint64(chunk) + 1)));
+}
+
+// Calls fill(begin, end, chunk) for every chunk, on the pool when there is more than one
+template <typename Fill>
+void forEachChunk(int size, WorkStealingPool *pool, const Fill &fill)
+{
+    const int chunks = (size + ChunkSize - 1) / ChunkSize;
+    if (chunks <= 1) {
+        fill(0, size, 0);
+        return;
+    }
+
+    WorkStealingPool &workers = pool ? *pool : WorkStealingPool::global();
+    WorkStealingPool::TaskGroup group(workers);
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        group.run([&fill, size, chunk]() {
+            const int begin = chunk * ChunkSize;
+            fill(begin, std::min(size, begin + ChunkSize), chunk);
+        });
+    }
+    group.wait();
+}
+
+int clampValue(double value, int size)
+{
+    if (!(value >= 1.0)) { // Also catches NaN
+        return 1;
+    }
+    return value >= double(size) ? size : int(value);
+}
+
+} // namespace
+
+namespace DataGenerator {
+
+QString distributionName(DataDistribution distribution)
+{
+    if (int(distribution) < 0 || distribution >= DataDistribution::Count) {
+        return QString();
+    }
+    return QString::fromLatin1(DistributionNames[int(distribution)]);
+}
+
+QStringList distributionNames()
+{
+    QStringList names;
+    for (const char *name : DistributionNames) {
+        names << QString::fromLatin1(name);
+    }
+    return names;
+}
+
+int findDistribution(const QString &name)
+{
+    for (int i = 0; i < int(DataDistribution::Count); ++i) {
+        if (name == QLatin1String(DistributionNames[i])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QVector<int> generate(DataDistribution distribution, int size, quint64 seed, WorkStealingPool *pool)
+{
+    size = std::clamp(size, 0, MaxSize);
+    QVector<int> values(size);
+    int *data = values.data();
+
+    switch (distribution) {
+    case DataDistribution::Random:
+    case DataDistribution::Sorted:
+    case DataDistribution::NearlySorted:
+        forEachChunk(size, pool, [data](int begin, int end, int) {
+            for (int i = begin; i < end; ++i) {
+                data[i] = i + 1;
+            }
+        });
+        break;
+    case DataDistribution::Uniform:
+        forEachChunk(size, pool, [data, size, seed](int begin, int end, int chunk) {
+            Random random = chunkRandom(seed, chunk);
+            for (int i = begin; i < end; ++i) {
+                data[i] = int(random.below(quint32(size))) + 1;
+            }
+        });
+        break;
+    case DataDistribution::Reversed:
+        forEachChunk(size, pool, [data, size](int begin, int end, int) {
+            for (int i = begin; i < end; ++i) {
+                data[i] = size - i;
+            }
+        });
+        break;
+    case DataDistribution::FewUnique:
+        forEachChunk(size, pool, [data, size, seed](int begin, int end, int chunk) {
+            Random random = chunkRandom(seed, chunk);
+            for (int i = begin; i < end; ++i) {
+                const qint64 step = qint64(random.below(FewUniqueValues)) + 1;
+                data[i] = std::max(1, int(step * size / (FewUniqueValues + 1)));
+            }
+        });
+        break;
+    case DataDistribution::OrganPipe:
+        forEachChunk(size, pool, [data, size](int begin, int end, int) {
+            const int half = (size + 1) / 2;
+            for (int i = begin; i < end; ++i) {
+                data[i] = i < half ? 2 * i + 1 : 2 * (size - i);
+            }
+        });
+        break;
+    case DataDistribution::Zipf:
+        // Inverse of the continuous 1/x distribution on [1, size + 1)
+        forEachChunk(size, pool, [data, size, seed](int begin, int end, int chunk) {
+            Random random = chunkRandom(seed, chunk);
+            const double logRange = std::log(double(size) + 1.0);
+            for (int i = begin; i < end; ++i) {
+                data[i] = clampValue(std::exp(random.unit() * logRange), size);
+            }
+        });
+        break;
+    case DataDistribution::Gaussian:
+        // Box-Muller, both outputs of each pair are used
+        forEachChunk(size, pool, [data, size, seed](int begin, int end, int chunk) {
+            Random random = chunkRandom(seed, chunk);
+            const double mean = size / 2.0;
+            const double deviation = size / 8.0;
+            for (int i = begin; i < end; i += 2) {
+                const double radius = std::sqrt(-2.0 * std::log(1.0 - random.unit()));
+                const double angle = 6.283185307179586 * random.unit();
+                data[i] = clampValue(std::round(mean + deviation * radius * std::cos(angle)), size);
+                if (i + 1 < end) {
+                    data[i + 1] = clampValue(std::round(mean + deviation * radius * std::sin(angle)), size);
+                }
+            }
+        });
+        break;
+    default:
+        return QVector<int>();
+    }
+
+    if (distribution == DataDistribution::Random) {
+        // Fisher-Yates needs the whole array, so this part stays on one thread
+        Random random(mix64(seed));
+        for (int i = size - 1; i > 0; --i) {
+            std::swap(data[i], data[random.below(quint32(i) + 1)]);
+        }
+    }
+    else if (distribution == DataDistribution::NearlySorted) {
+        // Neighbour swaps never cross a chunk boundary, so chunks stay independent
+        forEachChunk(size, pool, [data, seed](int begin, int end, int chunk) {
+            if (end - begin < 2) {
+                return;
+            }
+            Random random = chunkRandom(seed, chunk);
+            // 1% of the chunk, and at least one swap so small inputs are not left sorted
+            for (int swaps = std::max(1, (end - begin) / 100); swaps > 0; --swaps) {
+                const int j = begin + int(random.below(quint32(end - begin - 1)));
+                std::swap(data[j], data[j + 1]);
+            }
+        });
+    }
+
+    return values;
+}
+
+bool saveRaw(const QString &path, const QVector<int> &data, QString *error)
+{
+    QFile file(path);
+    const qint64 bytes = qint64(data.size()) * qint64(sizeof(qint32));
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate) || !file.resize(bytes)) {
+        if (error) {
+            *error = QString("Cannot write %1: %2").arg(path, file.errorString());
+        }
+        return false;
+    }
+    if (bytes == 0) {
+        return true;
+    }
+
+    uchar *map = file.map(0, bytes);
+    if (!map) {
+        if (error) {
+            *error = QString("Cannot map %1: %2").arg(path, file.errorString());
+        }
+        return false;
+    }
+    qToLittleEndian<qint32>(data.constData(), data.size(), map);
+    file.unmap(map);
+    return true;
+}
+
+QVector<int> loadRaw(const QString &path, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        return QVector<int>();
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(QString("Cannot open %1: %2").arg(path, file.errorString()));
+    }
+
+    const qint64 bytes = file.size();
+    if (bytes == 0 || bytes % qint64(sizeof(qint32)) != 0) {
+        return fail(QString("%1 is not a raw int32 file (%2 bytes)").arg(path).arg(bytes));
+    }
+    const qint64 count = bytes / qint64(sizeof(qint32));
+    if (count > MaxSize) {
+        return fail(QString("%1 holds %2 values, the limit is %3").arg(path).arg(count).arg(MaxSize));
+    }
+
+    uchar *map = file.map(0, bytes);
+    if (!map) {
+        return fail(QString("Cannot map %1: %2").arg(path, file.errorString()));
+    }
+    QVector<int> values(int(count));
+    qFromLittleEndian<qint32>(map, count, values.data());
+    file.unmap(map);
+    return values;
+}
+
+} // namespace DataGenerator
@@ -0,0 +1,47 @@
+#ifndef DATAGENERATOR_H
+#define DATAGENERATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class WorkStealingPool;
+
+// Input arrays shared by the charts and the benchmark, with values in 1..size.
+enum class DataDistribution : int {
+    Random,       // Shuffled permutation of 1..size, every value once
+    Uniform,      // Independent values, duplicates allowed
+    Sorted,
+    Reversed,
+    NearlySorted, // Sorted, then about 1% of the elements (at least one) swapped with a neighbour
+    FewUnique,    // 8 distinct values spread over the range
+    OrganPipe,    // Odd values rising to the middle, even values falling after it
+    Zipf,         // Skewed towards small values: k is about twice as likely as 2k
+    Gaussian,     // Bell curve around size / 2 with a standard deviation of size / 8
+    Count
+};
+
+// The array is a pure function of (distribution, size, seed). Work is split into fixed
+// chunks that each draw from their own random stream derived from the seed, so the number
+// of threads never changes the result and a seed reproduces the same input everywhere.
+namespace DataGenerator {
+
+constexpr int MaxSize = 100000000;
+
+// Names used by the combo box and the benchmark's --distributions, in enum order
+QString distributionName(DataDistribution distribution);
+QStringList distributionNames();
+// -1 when there is no distribution with this name
+int findDistribution(const QString &name);
+
+// Generates on pool, or on the global pool when none is given. Random shuffles sequentially.
+QVector<int> generate(DataDistribution distribution, int size, quint64 seed, WorkStealingPool *pool = nullptr);
+
+// Raw files hold little-endian int32 values and nothing else. Both directions go through a
+// memory map, so 100M element files are converted in place instead of through a stream.
+bool saveRaw(const QString &path, const QVector<int> &data, QString *error = nullptr);
+QVector<int> loadRaw(const QString &path, QString *error = nullptr);
+
+} // namespace DataGenerator
+
+#endif // DATAGENERATOR_H
@@ -1,10 +1,18 @@
 #include "mainwindow.h"
+#include "benchmark.h"
 
 #include <QApplication>
+#include <QCoreApplication>
 #include <QLocale>
 
 int main(int argc, char *argv[])
 {
+    // Headless benchmark: no window, no delays, no visualization
+    if (isBenchmarkInvocation(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return runBenchmark(app.arguments());
+    }
+
     QApplication a(argc, argv);
 
 
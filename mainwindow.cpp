@@ -5,6 +5,38 @@
 #include <QtCharts/QValueAxis>
 #include <QRandomGenerator>
 #include <QThread>
+#include <QDir>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <QLocale>
+#include <QFile>
+#include <QTextStream>
+#include "tracefile.h"
+#include "datagenerator.h"
+#include "sortalgorithms.h"
+#include <algorithm>
+#include <cmath>
+namespace {
+
+// 1234 -> "1,234", 12345678 -> "12.3M": short enough to overlay on a chart
+QString formatCount(long long count)
+{
+    if (count >= 10000000) {
+        return QString("%1M").arg(count / 1e6, 0, 'f', 1);
+    }
+    if (count >= 100000) {
+        return QString("%1k").arg(count / 1e3, 0, 'f', 0);
+    }
+    return QLocale().toString(count);
+}
+
+} // namespace
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
@@ -12,34 +44,75 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
 
-    // Timer initialization
-    milliseconds = 0;
-    seconds = 0;
-    minutes = 0;
+    qRegisterMetaType<SortStep>();
+    qRegisterMetaType<QVector<SortStep>>();
+    qRegisterMetaType<QSharedPointer<TraceSource>>();
 
+    // Stopwatch display, the time itself comes from a monotonic clock
+    timer.setInterval(StopwatchRefreshMs);
     connect(&timer, &QTimer::timeout, this, &MainWindow::process);
 
+    // Render timer: workers can produce steps far faster than the screen refreshes
+    renderTimer.setInterval(FrameIntervalMs);
+    renderTimer.setTimerType(Qt::PreciseTimer);
+    connect(&renderTimer, &QTimer::timeout, this, &MainWindow::renderFrame);
+
+    // Counters change with every step, a few refreshes per second are enough to read them
+    statsTimer.setInterval(StatsIntervalMs);
+    connect(&statsTimer, &QTimer::timeout, this, &MainWindow::updateStats);
+
     // Speed slider UI setup
     ui->speedSlider->setRange(0, 100);
     ui->speedSlider->setValue(100);
 
-    //shared vector to be sorted
-    sharedRandomVector = generateRandomVector(100);
+    // Algorithm list comes from the registry, combo box index == registry index
+    for (const SortAlgorithmInfo &info : sortAlgorithmTable) {
+        ui->comboBox->addItem(info.name);
+        ui->comboBox->setItemData(ui->comboBox->count() - 1,
+                                  QString("%1, %2, %3").arg(info.complexity,
+                                                            info.stable ? "stable" : "not stable",
+                                                            info.inPlace ? "in place" : "not in place"),
+                                  Qt::ToolTipRole);
+    }
 
-    // Set up charts
-    setupChartsGrid();
+    // Charts are added with the algorithms; until then the fast renderer shows an empty grid
+    barView = new BarView();
+    layoutCharts();
 
-    // Connect signals to slots
-    connect(ui->resetButton, &QPushButton::clicked, this, &MainWindow::on_resetButton_clicked);
-    connect(ui->startButton, &QPushButton::clicked, this, &MainWindow::on_startButton_clicked);
-    connect(ui->stopButton, &QPushButton::clicked, this, &MainWindow::on_stopButton_clicked);
-    connect(ui->speedSlider, &QAbstractSlider::valueChanged, this, &MainWindow::on_speedSlider_valueChanged);
-    connect(ui->clearAlgoButton, &QPushButton::clicked, this, &MainWindow::on_clearAlgoButton_clicked);
+    // Sorting threads for the whole session, one per core; charts beyond that wait their turn
+    workerPool = new WorkerPool(0, this);
+    for (Worker *worker : workerPool->workers()) {
+        connect(worker, &Worker::steps, this, &MainWindow::updateChartDuringSort, Qt::QueuedConnection);
+        connect(worker, &Worker::traceReady, this, &MainWindow::onTraceReady, Qt::QueuedConnection);
+    }
+    connect(workerPool, &WorkerPool::workerFinished, this, &MainWindow::onWorkerFinished);
+
+    // Distribution list, combo box index == DataDistribution
+    ui->distributionComboBox->addItems(DataGenerator::distributionNames());
+    ui->seedSpinBox->setValue(QRandomGenerator::global()->bounded(ui->seedSpinBox->maximum()));
+    // Element types, combo box index == sorting::ElementType
+    for (const sorting::ElementTypeInfo &info : sorting::elementTypeTable) {
+        ui->elementTypeComboBox->addItem(QString::fromLatin1(info.name));
+    }
+
+    //shared vector to be sorted, size and seed come from the data controls
+    on_generateButton_clicked();
+
+    // Playback controls only apply to recorded runs
+    on_modeComboBox_currentIndexChanged(ui->modeComboBox->currentIndex());
+
+    // The on_<object>_<signal> slots are connected by setupUi()
 }
 
 MainWindow::~MainWindow()
 {
-    on_stopButton_clicked();
+    // Cancel every run, paused ones included, and let the threads finish before the charts go
+    for (ChartSlot &slot : charts) {
+        if (slot.worker) {
+            slot.runToken->cancel();
+        }
+    }
+    delete workerPool;
     delete ui;
 }
 
@@ -47,102 +120,209 @@ MainWindow::~MainWindow()
 // RESET, START, STOP BUTTONS
 void MainWindow::on_resetButton_clicked()
 {
-    // In on_stopButton_clicked() or on_resetButton_clicked()
+    // Paused runs are cancelled below like the others; put the button back to Pause
+    setRunsPaused(false);
+    // Algorithm and data controls are locked only while something runs
     ui->comboBox->setEnabled(true);
+    ui->compareGapsButton->setEnabled(true);
+    ui->compareHeapsButton->setEnabled(true);
+    ui->dataLayoutWidget->setEnabled(true);
     ui->speedSlider->setEnabled(true);
     // Timer
-    timer.stop();
-    milliseconds = 0;
-    seconds = 0;
-    minutes = 0;
-    timer.setInterval(0);
-    ui->millisecLCD->display(milliseconds);
-    ui->secLCD->display(seconds);
-    ui->minLCD->display(minutes);
-
-    for (int i = 0; i < 6; ++i) {
-        if (threads[i]) {
-            threads[i]->requestInterruption();
-            threads[i]->quit();
-            threads[i]->wait();
-            threads[i] = nullptr;
-            workers[i] = nullptr;
+    resetStopwatch();
+    renderTimer.stop();
+    statsTimer.stop();
+    resetPlayback();
+    ui->modeComboBox->setEnabled(true);
+
+    removeCharts();
+}
+void MainWindow::on_startButton_clicked()
+{
+    ui->comboBox->setEnabled(false);
+    ui->compareGapsButton->setEnabled(false);
+    ui->compareHeapsButton->setEnabled(false);
+    ui->dataLayoutWidget->setEnabled(false);
+    ui->modeComboBox->setEnabled(false);
+    // The speed slider stays live: workers pick up the new step rate at their next step
+    // Starting new charts also resumes paused ones
+    if (runsPaused) {
+        setRunsPaused(false);
+    }
+    // Timer: a new race starts from zero, charts added to a running one join its clock
+    if (!isRunning()) {
+        resetStopwatch();
+    }
+    startStopwatch();
+    renderTimer.start();
+    statsTimer.start();
+    resetPlayback();
+
+    // Every chart that is not sorting yet gets in line, in grid order
+    for (int i = 0; i < charts.size(); ++i) {
+        ChartSlot &slot = charts[i];
+        if (slot.algorithmId < 0 || slot.worker || slot.queued) {
+            continue;
         }
-        chartOccupied[i] = false;
-        assignedAlgorithms[i].clear();
-        if (!barSeries[i]->barSets().isEmpty()) {
-            barSeries[i]->clear();
+        slot.queued = true;
+        queuedCharts << i;
+
+        // Show the input again until the run gets a worker
+        clearChart(i);
+        clearStats(i);
+        slot.data = sharedRandomVector;
+        updateChart(i, slot.data, slot.algorithm);
+        setChartTitle(i, QString("Algorithm: %1 (Queued)").arg(slot.algorithm));
+    }
+    startQueuedRuns();
+}
+
+void MainWindow::startQueuedRuns()
+{
+    // Workers of cancelled runs only count as free once they have noticed
+    while (!queuedCharts.isEmpty()) {
+        Worker *worker = workerPool->acquire();
+        if (!worker) {
+            return;
         }
-        charts[i]->setTitle("");
+        startRun(queuedCharts.takeFirst(), worker);
     }
 }
-void MainWindow::on_startButton_clicked()
+
+void MainWindow::startRun(int i, Worker *worker)
 {
-    ui->comboBox->setEnabled(false);
-    ui->speedSlider->setEnabled(false);
-    // Timer
-    timer.start();
+    ChartSlot &slot = charts[i];
+    slot.queued = false;
+    slot.worker = worker;
+
+    SortJob job;
+    job.chartIndex = i;
+    job.algorithm = SortAlgorithm(slot.algorithmId);
+    job.data = sharedRandomVector; // Shared, the worker sorts its own buffer
+    job.elementType = sorting::ElementType(ui->elementTypeComboBox->currentIndex());
+    job.recordOnly = replayMode;
+    if (replayMode && ui->streamToDiskCheckBox->isChecked()) {
+        job.traceFilePath = traceFilePath(i);
+        job.seed = dataSeed;
+    }
+    slot.runToken = job.token;
+    if (runsPaused) {
+        // A run that finished while the others were paused hands its worker to a paused one
+        slot.runToken->pause();
+    }
+    slot.counters = job.counters;
+    slot.statsLabel->clear();
+    slot.statsLabel->setVisible(!useFastBars);
+    slot.data = sharedRandomVector; // Mirror that the worker's steps are applied to
+    slot.owners.clear();
+    if (sortAlgorithmTable[slot.algorithmId].parallel) {
+        slot.owners.fill(0, sharedRandomVector.size());
+    }
+    if (job.elementType == sorting::ElementType::Int32) {
+        setChartTitle(i, QString("Algorithm: %1").arg(slot.algorithm));
+    }
+    else {
+        setChartTitle(i, QString("Algorithm: %1 (%2)").arg(slot.algorithm, sorting::elementTypeInfo(job.elementType).name));
+    }
+
+    worker->setSpeed(ui->speedSlider->value()); // Pass the speed value
+    worker->start(job);
+    activeWorkers++;
+}
 
-    activeWorkers = 0; // Reset activeWorkers before starting
-
-    // Start sorting in threads
-    for (int i = 0; i < 6; ++i) {
-        if (chartOccupied[i] && !assignedAlgorithms[i].isEmpty() && threads[i] == nullptr) {
-            // Create a new thread
-            threads[i] = new QThread;
-
-            // Create a worker instance
-            workers[i] = new Worker;
-            QVector<int> dataCopy = sharedRandomVector;
-            workers[i]->setData(dataCopy); // Use a copy of your shared vector
-            workers[i]->setAlgorithm(assignedAlgorithms[i]);
-            workers[i]->setChartIndex(i); // We'll add this method to keep track of the chart index
-            workers[i]->setSpeed(ui->speedSlider->value()); // Pass the speed value
-
-            // Move the worker to the thread
-            workers[i]->moveToThread(threads[i]);
-
-            // Connect signals and slots between worker and main thread
-            connect(threads[i], &QThread::started, workers[i], &Worker::process);
-            connect(workers[i], &Worker::progress, this, &MainWindow::updateChartDuringSort, Qt::QueuedConnection);
-
-            connect(workers[i], &Worker::finished, threads[i], &QThread::quit);
-            connect(workers[i], &Worker::finished, workers[i], &Worker::deleteLater);
-            connect(threads[i], &QThread::finished, threads[i], &QThread::deleteLater);
-
-            // When thread is finished, reset pointers
-            connect(threads[i], &QThread::finished, this, [this, i]() {
-                threads[i] = nullptr;
-                workers[i] = nullptr;
-                activeWorkers--;
-
-                finishSorting(i);
-                if (activeWorkers == 0) {
-                    // Stop the timer
-                    timer.stop();
-
-                    // Re-enable UI elements
-                    ui->comboBox->setEnabled(true);
-                }
-            });
-
-            // Start the thread
-            threads[i]->start();
-            activeWorkers++; // Increment activeWorkers when we actually start a worker
+// Steps and traces of a cancelled run arrive before its worker is back, and by then the
+// chart it was sorting for no longer refers to that worker
+void MainWindow::onWorkerFinished(Worker *worker)
+{
+    for (int i = 0; i < charts.size(); ++i) {
+        if (charts[i].worker == worker) {
+            runFinished(i);
+            return;
         }
     }
+    startQueuedRuns();
 }
 
+void MainWindow::runFinished(int index)
+{
+    charts[index].worker = nullptr;
+    activeWorkers--;
+    startQueuedRuns();
+
+    // Recorded runs finish when their playback reaches the end
+    if (replayMode) {
+        if (!isRunning()) {
+            stopStopwatch();
+            statsTimer.stop();
+            updateStats();
+            ui->comboBox->setEnabled(true);
+            ui->compareGapsButton->setEnabled(true);
+            ui->compareHeapsButton->setEnabled(true);
+            ui->dataLayoutWidget->setEnabled(true);
+            ui->modeComboBox->setEnabled(true);
+            startPlayback();
+            showSummary();
+        }
+        return;
+    }
 
+    // Draw whatever arrived after the last frame
+    if (charts[index].dirty) {
+        charts[index].dirty = false;
+        updateChart(index, charts[index].data, charts[index].algorithm);
+    }
+
+    finishSorting(index);
+    if (!isRunning()) {
+        // Stop the timers
+        stopStopwatch();
+        renderTimer.stop();
+        statsTimer.stop();
+        updateStats();
+        showSummary();
+
+        // Re-enable UI elements
+        ui->comboBox->setEnabled(true);
+        ui->compareGapsButton->setEnabled(true);
+        ui->compareHeapsButton->setEnabled(true);
+        ui->dataLayoutWidget->setEnabled(true);
+        ui->modeComboBox->setEnabled(true);
+    }
+}
+
+
+// Pauses or resumes the running workers, and pauses the playback of a recording
 void MainWindow::on_stopButton_clicked()
 {
-    // Timer
-    timer.stop();
-    for (int i = 0; i < 6; ++i) {
-        if (threads[i]) {
-            threads[i]->requestInterruption();
+    setPlaying(false);
+
+    if (isRunning()) {
+        setRunsPaused(!runsPaused);
+    }
+}
+
+void MainWindow::setRunsPaused(bool paused)
+{
+    runsPaused = paused;
+    for (ChartSlot &slot : charts) {
+        if (slot.worker && slot.runToken) {
+            if (paused) {
+                slot.runToken->pause();
+            }
+            else {
+                slot.runToken->resume();
+            }
         }
     }
+    ui->stopButton->setText(paused ? "Resume" : "Pause");
+
+    // Paused time is not sorting time
+    if (paused) {
+        stopStopwatch();
+    }
+    else if (isRunning()) {
+        startStopwatch();
+    }
 }
 
 // SPEED SLIDER
@@ -150,64 +330,86 @@ void MainWindow::on_speedSlider_valueChanged(int value)
 {
     ui->speedLCD->display(value);
 
-    if (value > 0) {
-        int newInterval = 100 / value; // Adjust as needed for speed control
-        timer.setInterval(newInterval);
-    }
-    // Update speed in all active workers
-    for (int i = 0; i < 6; ++i) {
-        if (workers[i]) {
-            workers[i]->setSpeed(value);
+    // Update the step rate of all active workers, they apply it without restarting
+    for (ChartSlot &slot : charts) {
+        if (slot.worker) {
+            slot.worker->setSpeed(value);
         }
     }
 }
 
 void MainWindow::on_comboBox_activated(int index)
 {
-    QString algorithm = ui->comboBox->itemText(index);
-
-    // Check if the placeholder is selected
-    if (algorithm == "Select an algorithm") {
-        return; // Do nothing if the placeholder is selected
+    if (index < 0 || index >= sortAlgorithmCount()) {
+        return;
     }
+    if (charts.size() >= MaxCharts) {
+        QMessageBox::information(this, "Add algorithm", QString("The grid holds at most %1 charts, clear them first.").arg(MaxCharts));
+        return;
+    }
+    QString algorithm = sortAlgorithmTable[index].name;
 
-    // Use the shared random vector (which has 500 unique values)
-    QVector<int> &values = sharedRandomVector;
-
-    // Find the first available chart slot that is empty
-    for (int i = 0; i < 6; ++i) {
-        if (!chartOccupied[i]) {
-            // Assign the algorithm to this chart and mark it as occupied
-            chartOccupied[i] = true;
-
-            // Store the assigned algorithm name
-            assignedAlgorithms[i] = algorithm;
+    // Every chart sorts the same shared input; the same algorithm may be added more than once
+    const int i = addChart(algorithm, index);
+    charts[i].data = sharedRandomVector;
+    updateChart(i, charts[i].data, algorithm);
+    setChartTitle(i, QString("Algorithm: %1").arg(algorithm));
+}
+// RENDERER SELECTION
+void MainWindow::on_rendererComboBox_currentIndexChanged(int index)
+{
+    useFastBars = (index == 1);
+    layoutCharts();
 
-            // Update the chart with the selected algorithm and shared values
-            updateChart(i, values, algorithm);
+    // The view that was hidden is stale, bring it up to date
+    for (int i = 0; i < charts.size(); ++i) {
+        if (!charts[i].data.isEmpty()) {
+            updateChart(i, charts[i].data, charts[i].algorithm);
+        }
+    }
+}
 
-            // Update the chart title
-            charts[i]->setTitle(QString("Algorithm: %1").arg(algorithm));
+void MainWindow::setChartTitle(int index, const QString &title)
+{
+    charts[index].chart->setTitle(title);
+    barView->setTitle(index, title);
+}
 
-            break; // Break after assigning one chart
-        }
+void MainWindow::clearChart(int index)
+{
+    ChartSlot &slot = charts[index];
+    if (!slot.barSeries->barSets().isEmpty()) {
+        slot.barSeries->clear();
     }
+    barView->clear(index);
+    slot.highlights.clear();
+    slot.owners.clear();
 }
+
 void MainWindow::updateChart(int index, const QVector<int> &values, const QString &algorithm)
 {
-    if (index < 0 || index >= 6) {
+    if (index < 0 || index >= charts.size()) {
         qWarning() << "Invalid chart index:" << index;
         return;
     }
+    ChartSlot &slot = charts[index];
+
+    // Fast renderer draws the whole array in one pass
+    if (useFastBars) {
+        barView->setHighlights(index, slot.highlights);
+        barView->setOwners(index, slot.owners);
+        barView->setValues(index, values);
+        return;
+    }
 
     // Retrieve the bar sets for the series
-    QList<QBarSet*> sets = barSeries[index]->barSets();
+    QList<QBarSet*> sets = slot.barSeries->barSets();
 
     // If no bar sets exist, create one
     if (sets.isEmpty()) {
         QBarSet *set = new QBarSet(algorithm);
         set->setColor(Qt::blue); // Assign a consistent color
-        barSeries[index]->append(set);
+        slot.barSeries->append(set);
 
         // Initialize the set with values
         for (const int &value : values) {
@@ -234,7 +436,7 @@ void MainWindow::updateChart(int index, const QVector<int> &values, const QStrin
     }
 
     // Adjust axes ranges only if necessary
-    QChart *chart = charts[index];
+    QChart *chart = slot.chart;
 
     // Fixing Clazy warning by storing the axis lists in local variables
     const QList<QAbstractAxis *> horizontalAxes = chart->axes(Qt::Horizontal);
@@ -276,113 +478,427 @@ void MainWindow::updateChart(int index, const QVector<int> &values, const QStrin
 
 
 
-void MainWindow::updateChartDuringSort(int chartIndex, const QVector<int> &data)
+void MainWindow::updateChartDuringSort(int chartIndex, const QVector<SortStep> &steps)
 {
-    // Update the chart at chartIndex with the new data
-    updateChart(chartIndex, data, assignedAlgorithms[chartIndex]);
+    // Batches of a cancelled run can still be queued after its chart was reset or removed
+    if (chartIndex < 0 || chartIndex >= charts.size() || sender() != charts[chartIndex].worker) {
+        return;
+    }
+    ChartSlot &slot = charts[chartIndex];
+
+    // Apply the deltas to the chart's mirror; the next frame redraws it
+    applySteps(slot.data, steps);
+    slot.highlights = recentIndices(steps);
+    if (!slot.owners.isEmpty()) {
+        applyOwners(slot.owners, steps);
+    }
+    slot.dirty = true;
 }
 
-void MainWindow::on_clearAlgoButton_clicked()
+void MainWindow::renderFrame()
 {
-    // Set all chartOccupied values to false to mark all charts as unoccupied
-    for (int i = 0; i < 6; ++i) {
-        chartOccupied[i] = false;
+    if (playing) {
+        advancePlayback();
+    }
 
-        if (!barSeries[i]->barSets().isEmpty()) {
-            barSeries[i]->clear(); // Clear the chart data
+    // Only the latest state of each chart is drawn, intermediate states are dropped. The fast
+    // renderer collects every chart updated here into a single repaint of its widget.
+    for (int i = 0; i < charts.size(); ++i) {
+        if (charts[i].dirty) {
+            charts[i].dirty = false;
+            updateChart(i, charts[i].data, charts[i].algorithm);
         }
+    }
+}
+
+// Adds a chart for every registry entry from first to last, all sorting the shared input
+void MainWindow::addAlgorithms(SortAlgorithm first, SortAlgorithm last, const QString &title)
+{
+    if (charts.size() + (int(last) - int(first) + 1) > MaxCharts) {
+        QMessageBox::information(this, title, QString("The grid holds at most %1 charts, clear them first.").arg(MaxCharts));
+        return;
+    }
 
-        charts[i]->setTitle("Add an algorithm");
+    for (int id = int(first); id <= int(last); ++id) {
+        on_comboBox_activated(id);
     }
 }
 
+// Side by side comparison of every gap sequence on the shared input
+void MainWindow::on_compareGapsButton_clicked()
+{
+    addAlgorithms(SortAlgorithm::Shell, SortAlgorithm::ShellTokuda, "Compare Shell gaps");
+}
+
+// The binary heap next to its cache-aware variants
+void MainWindow::on_compareHeapsButton_clicked()
+{
+    addAlgorithms(SortAlgorithm::Heap, SortAlgorithm::HeapPrefetch, "Compare heaps");
+}
+
+void MainWindow::on_clearAlgoButton_clicked()
+{
+    // Charts only exist for their algorithms, clearing them cancels what they are running
+    if (isRunning()) {
+        on_resetButton_clicked();
+        return;
+    }
+    resetPlayback();
+    removeCharts();
+}
+
 // TIMER PROCESSING FUNCTION
 void MainWindow::process()
 {
-    // Update milliseconds
-    milliseconds++;
+    const qint64 elapsed = stopwatchBankedMs + (stopwatch.isValid() ? stopwatch.elapsed() : 0);
+
+    // Update LCD Displays
+    ui->millisecLCD->display(int(elapsed % 1000));
+    ui->secLCD->display(int(elapsed / 1000 % 60));
+    ui->minLCD->display(int(elapsed / 60000));
+}
 
-    // Update seconds and minutes as needed
-    if (milliseconds == 1000) {
-        milliseconds = 0;
-        seconds++;
+void MainWindow::startStopwatch()
+{
+    if (!stopwatch.isValid()) {
+        stopwatch.start();
     }
+    timer.start();
+}
 
-    if (seconds == 60) {
-        seconds = 0;
-        minutes++;
+void MainWindow::stopStopwatch()
+{
+    if (stopwatch.isValid()) {
+        stopwatchBankedMs += stopwatch.elapsed();
+        stopwatch.invalidate();
     }
+    timer.stop();
+    process(); // Show the exact final time, not the last refresh
+}
 
-    // Update LCD Displays
-    ui->millisecLCD->display(milliseconds);
-    ui->secLCD->display(seconds);
-    ui->minLCD->display(minutes);
+void MainWindow::resetStopwatch()
+{
+    stopwatch.invalidate();
+    stopwatchBankedMs = 0;
+    timer.stop();
+    process();
 }
 
-// CHARTS IN GRID
-void MainWindow::setupChartsGrid()
+// RECORD & REPLAY
+void MainWindow::on_modeComboBox_currentIndexChanged(int index)
 {
-    QGridLayout *layout = ui->chartsGrid;
+    replayMode = (index == 1);
+
+    ui->playPauseButton->setEnabled(replayMode);
+    ui->stepBackButton->setEnabled(replayMode);
+    ui->stepForwardButton->setEnabled(replayMode);
+    ui->seekSlider->setEnabled(replayMode);
+}
+
+void MainWindow::onTraceReady(int chartIndex, const QSharedPointer<TraceSource> &trace)
+{
+    if (chartIndex < 0 || chartIndex >= charts.size() || sender() != charts[chartIndex].worker) {
+        return;
+    }
+
+    charts[chartIndex].player.setTrace(trace);
+    playbackLength = qMax(playbackLength, trace->length());
+}
 
+void MainWindow::startPlayback()
+{
+    ui->seekSlider->setRange(0, playbackLength);
+    seekPlayback(0);
+    setPlaying(true);
+}
+
+void MainWindow::resetPlayback()
+{
+    setPlaying(false);
+    playbackPosition = 0;
+    playbackLength = 0;
+    playbackCarry = 0.0;
+    for (ChartSlot &slot : charts) {
+        slot.player.reset();
+        slot.playbackFinished = false;
+    }
+    ui->seekSlider->setRange(0, 0);
+}
+
+void MainWindow::setPlaying(bool play)
+{
+    bool hasTrace = false;
+    for (const ChartSlot &slot : std::as_const(charts)) {
+        hasTrace = hasTrace || slot.player.isValid();
+    }
+
+    playing = play && hasTrace;
+    if (playing) {
+        // Restart from the beginning when play is pressed at the end
+        if (playbackPosition >= playbackLength) {
+            seekPlayback(0);
+        }
+        playbackCarry = 0.0;
+        frameClock.start();
+        renderTimer.start();
+    }
+    ui->playPauseButton->setText(playing ? "Pause" : "Play");
+}
+
+// Speed slider maps exponentially from 1 to 100000 steps per second
+double MainWindow::playbackStepsPerSecond() const
+{
+    return std::pow(10.0, ui->speedSlider->value() / 20.0);
+}
+
+void MainWindow::advancePlayback()
+{
+    // Advance by wall-clock time, not by frame count, so late frames don't slow playback down
+    playbackCarry += playbackStepsPerSecond() * frameClock.restart() / 1000.0;
+    const int stepCount = int(qMin(playbackCarry, double(playbackLength)));
+    playbackCarry -= stepCount;
+
+    if (stepCount > 0) {
+        seekPlayback(playbackPosition + stepCount);
+    }
+    if (playbackPosition >= playbackLength) {
+        setPlaying(false);
+    }
+}
+
+void MainWindow::seekPlayback(int position)
+{
+    playbackPosition = qBound(0, position, playbackLength);
+    ui->seekSlider->setValue(playbackPosition);
+
+    // Every chart shows the same step index, so shorter traces simply end earlier
+    for (int i = 0; i < charts.size(); ++i) {
+        ChartSlot &slot = charts[i];
+        if (!slot.player.isValid()) {
+            continue;
+        }
+
+        slot.player.seek(playbackPosition);
+        slot.data = slot.player.data();
+        slot.highlights = slot.player.recentIndices();
+        slot.dirty = true;
+
+        if (slot.player.atEnd() && !slot.playbackFinished) {
+            slot.playbackFinished = true;
+            finishSorting(i);
+        }
+        else if (!slot.player.atEnd() && slot.playbackFinished) {
+            // Seeking back from the end undoes the completed look
+            slot.playbackFinished = false;
+            const QList<QBarSet*> sets = slot.barSeries->barSets();
+            if (!sets.isEmpty()) {
+                sets.first()->setColor(Qt::blue);
+            }
+            barView->setBarColor(i, Qt::blue);
+            setChartTitle(i, QString("Algorithm: %1").arg(slot.algorithm));
+        }
+    }
+}
+
+void MainWindow::on_playPauseButton_clicked()
+{
+    setPlaying(!playing);
+}
 
-    for (int i = 0; i < 6; ++i) {
-        // Create a new QChart
-        charts[i] = new QChart();
-        charts[i]->setTitle("Add an algorithm");
-        charts[i]->setBackgroundVisible(false); // Hide the background of the chart
-        charts[i]->setMargins(QMargins(0, 0, 0, 0)); // Remove any margins for a clean appearance
-        charts[i]->setAnimationOptions(QChart::SeriesAnimations);
+void MainWindow::on_stepBackButton_clicked()
+{
+    setPlaying(false);
+    seekPlayback(playbackPosition - 1);
+}
 
-        // Create a new QBarSeries and add it to the chart
-        barSeries[i] = new QBarSeries();
-        charts[i]->addSeries(barSeries[i]);
+void MainWindow::on_stepForwardButton_clicked()
+{
+    setPlaying(false);
+    seekPlayback(playbackPosition + 1);
+}
 
-        // Set up a vertical axis (Y axis) to display values without labels or grid lines
-        QValueAxis *axisY = new QValueAxis();
-        axisY->setRange(0, 100); // Adjust this range depending on the values to be visualized
-        axisY->setLabelsVisible(false); // Hide labels on the Y axis
-        axisY->setGridLineVisible(false); // Hide grid lines
-        charts[i]->addAxis(axisY, Qt::AlignLeft);
-        barSeries[i]->attachAxis(axisY);
+void MainWindow::on_seekSlider_sliderMoved(int position)
+{
+    seekPlayback(position);
+}
 
-        // Set up a horizontal axis (X axis) without labels or grid lines
-        QValueAxis *axisX = new QValueAxis();
-        axisX->setLabelsVisible(false); // Hide labels on the X axis
-        axisX->setGridLineVisible(false); // Hide grid lines
-        charts[i]->addAxis(axisX, Qt::AlignBottom);
-        barSeries[i]->attachAxis(axisX);
+// TRACE FILES
+QString MainWindow::traceFilePath(int index) const
+{
+    return QDir(QDir::tempPath()).filePath(QString("algorithm-visualizer-chart%1.strace").arg(index));
+}
+
+void MainWindow::on_saveTracesButton_clicked()
+{
+    const QString directory = QFileDialog::getExistingDirectory(this, "Save traces to");
+    if (directory.isEmpty()) {
+        return;
+    }
 
-        // Create a QChartView for displaying the chart
-        chartViews[i] = new QChartView(charts[i]);
-        chartViews[i]->setRenderHint(QPainter::Antialiasing);
+    int saved = 0;
+    for (int i = 0; i < charts.size(); ++i) {
+        if (!charts[i].player.isValid()) {
+            continue;
+        }
 
-        // Add the QChartView to the grid layout
-        layout->addWidget(chartViews[i], i / 2, i % 2); // i / 2 determines the row, i % 2 determines the column
+        QString name = charts[i].algorithm;
+        name.replace(' ', '-');
+        const QString path = QDir(directory).filePath(QString("chart%1-%2.strace").arg(i + 1).arg(name));
+        if (!TraceFileWriter::save(*charts[i].player.trace(), path, dataSeed)) {
+            QMessageBox::warning(this, "Save traces", QString("Could not write %1").arg(path));
+            return;
+        }
+        saved++;
+    }
+
+    if (saved == 0) {
+        QMessageBox::information(this, "Save traces", "Record a run in Record & replay mode first.");
     }
 }
-//Random vecot rot o be sorted generator
-QVector<int> MainWindow::generateRandomVector(int size)
+
+void MainWindow::on_loadTraceButton_clicked()
 {
-    QVector<int> values;
-    values.reserve(size);
-    for (int i = 1; i <= size; ++i) {
-        values.append(i);
+    const QString path = QFileDialog::getOpenFileName(this, "Load trace", QString(), "Sort traces (*.strace)");
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QString error;
+    QSharedPointer<TraceFile> trace = TraceFile::open(path, &error);
+    if (!trace) {
+        QMessageBox::warning(this, "Load trace", error);
+        return;
+    }
+
+    if (charts.size() >= MaxCharts) {
+        QMessageBox::information(this, "Load trace", QString("The grid holds at most %1 charts, clear them first.").arg(MaxCharts));
+        return;
     }
 
-    // Shuffle the vector using QRandomGenerator
-    std::shuffle(values.begin(), values.end(), *QRandomGenerator::global());
+    // Loaded traces only make sense in replay mode
+    ui->modeComboBox->setCurrentIndex(1);
+
+    const int i = addChart(trace->algorithm(), findSortAlgorithm(trace->algorithm()));
+    ChartSlot &slot = charts[i];
+    slot.player.setTrace(trace);
+    playbackLength = qMax(playbackLength, trace->length());
+    ui->seekSlider->setRange(0, playbackLength);
+
+    slot.data = slot.player.data();
+    updateChart(i, slot.data, slot.algorithm);
+    setChartTitle(i, QString("Algorithm: %1").arg(slot.algorithm));
+
+    // Line the new chart up with the others
+    slot.playbackFinished = false;
+    seekPlayback(playbackPosition);
+    renderTimer.start();
+}
 
-    return values;
+// CHARTS IN GRID
+int MainWindow::addChart(const QString &algorithm, int algorithmId)
+{
+    ChartSlot slot;
+    slot.algorithm = algorithm;
+    slot.algorithmId = algorithmId;
+
+    // Create a new QChart
+    slot.chart = new QChart();
+    slot.chart->setBackgroundVisible(false); // Hide the background of the chart
+    slot.chart->setMargins(QMargins(0, 0, 0, 0)); // Remove any margins for a clean appearance
+    slot.chart->setAnimationOptions(QChart::SeriesAnimations);
+
+    // Create a new QBarSeries and add it to the chart
+    slot.barSeries = new QBarSeries();
+    slot.chart->addSeries(slot.barSeries);
+
+    // Set up a vertical axis (Y axis) to display values without labels or grid lines
+    QValueAxis *axisY = new QValueAxis();
+    axisY->setRange(0, 100); // Adjust this range depending on the values to be visualized
+    axisY->setLabelsVisible(false); // Hide labels on the Y axis
+    axisY->setGridLineVisible(false); // Hide grid lines
+    slot.chart->addAxis(axisY, Qt::AlignLeft);
+    slot.barSeries->attachAxis(axisY);
+
+    // Set up a horizontal axis (X axis) without labels or grid lines
+    QValueAxis *axisX = new QValueAxis();
+    axisX->setLabelsVisible(false); // Hide labels on the X axis
+    axisX->setGridLineVisible(false); // Hide grid lines
+    slot.chart->addAxis(axisX, Qt::AlignBottom);
+    slot.barSeries->attachAxis(axisX);
+
+    // Create a QChartView for displaying the chart, the view owns the chart
+    slot.chartView = new QChartView(slot.chart);
+    slot.chartView->setRenderHint(QPainter::Antialiasing);
+
+    // Counter overlay in the top left corner of the chart view
+    slot.statsLabel = new QLabel();
+    slot.statsLabel->setStyleSheet("QLabel { background: rgba(255, 255, 255, 200); padding: 2px; }");
+    slot.statsLabel->setAttribute(Qt::WA_TransparentForMouseEvents);
+    slot.statsLabel->hide();
+
+    charts.append(slot);
+    layoutCharts();
+
+    // Past a dozen charts the chart views are too slow to animate, draw them all in one widget
+    if (charts.size() > MaxChartViews && !useFastBars) {
+        ui->rendererComboBox->setCurrentIndex(1);
+    }
+    return int(charts.size()) - 1;
 }
 
+// Cancels every run and removes all charts. The workers return to the pool by themselves
+// once they notice, the GUI doesn't wait for them.
+void MainWindow::removeCharts()
+{
+    queuedCharts.clear();
+    for (ChartSlot &slot : charts) {
+        if (slot.worker) {
+            slot.runToken->cancel();
+        }
+        delete slot.chartView;
+        delete slot.statsLabel;
+    }
+    charts.clear();
+    activeWorkers = 0;
+    layoutCharts();
+}
+
+void MainWindow::layoutCharts()
+{
+    QGridLayout *layout = ui->chartsGrid;
+    const int count = int(charts.size());
+    const int columns = BarView::gridColumns(count);
+    const int rows = qMax(1, (count + columns - 1) / columns);
+
+    // Take everything out first, a widget added again while still in the layout is only warned about
+    for (const ChartSlot &slot : std::as_const(charts)) {
+        layout->removeWidget(slot.chartView);
+        layout->removeWidget(slot.statsLabel);
+    }
+    layout->removeWidget(barView);
+
+    for (int i = 0; i < count; ++i) {
+        const ChartSlot &slot = charts[i];
+        layout->addWidget(slot.chartView, i / columns, i % columns);
+        layout->addWidget(slot.statsLabel, i / columns, i % columns, Qt::AlignTop | Qt::AlignLeft);
+        slot.chartView->setVisible(!useFastBars);
+        slot.statsLabel->setVisible(!useFastBars && slot.counters);
+    }
+
+    // The fast renderer covers the whole grid and also shows the hint while there are no charts
+    barView->setPanelCount(count);
+    layout->addWidget(barView, 0, 0, rows, columns);
+    barView->setVisible(useFastBars || count == 0);
+}
 // finish sorting
 void MainWindow::finishSorting(int index)
 {
-    if (index < 0 || index >= 6) {
+    if (index < 0 || index >= charts.size()) {
         return; // Check for valid index
     }
+    ChartSlot &slot = charts[index];
 
-    const QList<QBarSet*> sets = barSeries[index]->barSets(); // Store QList in a variable
+    const QList<QBarSet*> sets = slot.barSeries->barSets(); // Store QList in a variable
 
     if (!sets.isEmpty()) {
         QBarSet *set = sets.first(); // Safe access
@@ -390,8 +906,203 @@ void MainWindow::finishSorting(int index)
         // Set all bars to green
         set->setColor(QColor(Qt::green));
     }
+    slot.highlights.clear();
+    slot.owners.clear();
+    barView->setHighlights(index, slot.highlights);
+    barView->setOwners(index, slot.owners);
+    barView->setBarColor(index, QColor(Qt::green));
+
+    // Update the chart title to indicate completion, with the run's own time in live races
+    if (slot.counters && !replayMode) {
+        const double seconds = slot.counters->wallNs.load(std::memory_order_relaxed) / 1e9;
+        setChartTitle(index, QString("Algorithm: %1 (Completed in %2 s)").arg(slot.algorithm).arg(seconds, 0, 'f', 3));
+    }
+    else {
+        setChartTitle(index, QString("Algorithm: %1 (Completed)").arg(slot.algorithm));
+    }
+}
+
+// INPUT DATA
+void MainWindow::setSharedData(const QVector<int> &values, quint64 seed)
+{
+    sharedRandomVector = values;
+    dataSeed = seed;
 
-    // Update the chart title to indicate completion
-    charts[index]->setTitle(QString("Algorithm: %1 (Completed)").arg(assignedAlgorithms[index]));
+    if (values.size() > MaxChartBars && !useFastBars) {
+        ui->rendererComboBox->setCurrentIndex(1);
+    }
+
+    // Charts waiting to be started show the new input right away
+    for (int i = 0; i < charts.size(); ++i) {
+        ChartSlot &slot = charts[i];
+        if (slot.worker || slot.algorithmId < 0) {
+            continue;
+        }
+        clearChart(i);
+        slot.data = values;
+        updateChart(i, slot.data, slot.algorithm);
+        setChartTitle(i, QString("Algorithm: %1").arg(slot.algorithm));
+    }
+}
+
+void MainWindow::on_generateButton_clicked()
+{
+    const auto distribution = DataDistribution(ui->distributionComboBox->currentIndex());
+    const quint64 seed = quint64(ui->seedSpinBox->value());
+    setSharedData(DataGenerator::generate(distribution, ui->dataSizeSpinBox->value(), seed), seed);
+}
+
+void MainWindow::on_loadDataButton_clicked()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "Load data", QString(), "Raw int32 data (*.bin *.raw);;All files (*)");
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QString error;
+    const QVector<int> values = DataGenerator::loadRaw(path, &error);
+    if (values.isEmpty()) {
+        QMessageBox::warning(this, "Load data", error);
+        return;
+    }
+    ui->dataSizeSpinBox->setValue(int(values.size()));
+    setSharedData(values, 0);
 }
 
+void MainWindow::on_saveDataButton_clicked()
+{
+    const QString path = QFileDialog::getSaveFileName(this, "Save data", QString(), "Raw int32 data (*.bin *.raw)");
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QString error;
+    if (!DataGenerator::saveRaw(path, sharedRandomVector, &error)) {
+        QMessageBox::warning(this, "Save data", error);
+    }
+}
+
+// LIVE COUNTERS
+void MainWindow::updateStats()
+{
+    for (int i = 0; i < charts.size(); ++i) {
+        if (!charts[i].counters) {
+            continue;
+        }
+
+        const sorting::SortCounters &counters = *charts[i].counters;
+        const QString text = QString("%1 comparisons, %2 swaps, %3 writes\n"
+                                        "%4 cache misses (est.), %5 data + %6 aux, %7 ms CPU\n"
+                                        "%8 ms: %9 sorting, %10 waiting")
+                                    .arg(formatCount(counters.comparisons.load(std::memory_order_relaxed)),
+                                         formatCount(counters.swaps.load(std::memory_order_relaxed)),
+                                         formatCount(counters.writes.load(std::memory_order_relaxed)),
+                                         formatCount(counters.cacheMisses.load(std::memory_order_relaxed)),
+                                         QLocale().formattedDataSize(counters.dataBytes.load(std::memory_order_relaxed)),
+                                         QLocale().formattedDataSize(counters.auxBytes.load(std::memory_order_relaxed)))
+                                    .arg(counters.cpuNs.load(std::memory_order_relaxed) / 1e6, 0, 'f', 1)
+                                    .arg(counters.wallNs.load(std::memory_order_relaxed) / 1e6, 0, 'f', 1)
+                                    .arg(counters.algorithmNs() / 1e6, 0, 'f', 1)
+                                    .arg(counters.waitNs.load(std::memory_order_relaxed) / 1e6, 0, 'f', 1);
+        charts[i].statsLabel->setText(text);
+        barView->setOverlay(i, text);
+    }
+}
+
+void MainWindow::clearStats(int index)
+{
+    charts[index].counters.reset();
+    charts[index].statsLabel->clear();
+    charts[index].statsLabel->hide();
+    barView->setOverlay(index, QString());
+}
+
+void MainWindow::showSummary()
+{
+    QVector<int> finished;
+    for (int i = 0; i < charts.size(); ++i) {
+        if (charts[i].counters && charts[i].runToken && !charts[i].runToken->isCancelled()) {
+            finished << i;
+        }
+    }
+    if (finished.isEmpty()) {
+        return;
+    }
+
+    const QStringList headers = {"Algorithm", "Comparisons", "Swaps", "Writes", "Cache misses (est.)",
+                                 "Data memory (KB)", "Aux memory (KB)", "CPU time (ms)", "Wall time (ms)",
+                                 "Sorting (ms)", "Waiting (ms)", "Emitting steps (ms)"};
+    const QStringList csvHeaders = {"algorithm", "comparisons", "swaps", "writes", "cache_misses", "data_memory_kb",
+                                    "aux_memory_kb", "cpu_ms", "wall_ms", "sorting_ms", "waiting_ms", "emitting_ms"};
+
+    QVector<QVariantList> rows;
+    for (int chart : std::as_const(finished)) {
+        const sorting::SortCounters &counters = *charts[chart].counters;
+        rows << QVariantList{
+            charts[chart].algorithm,
+            qlonglong(counters.comparisons.load(std::memory_order_relaxed)),
+            qlonglong(counters.swaps.load(std::memory_order_relaxed)),
+            qlonglong(counters.writes.load(std::memory_order_relaxed)),
+            qlonglong(counters.cacheMisses.load(std::memory_order_relaxed)),
+            counters.dataBytes.load(std::memory_order_relaxed) / 1024.0,
+            counters.auxBytes.load(std::memory_order_relaxed) / 1024.0,
+            counters.cpuNs.load(std::memory_order_relaxed) / 1e6,
+            counters.wallNs.load(std::memory_order_relaxed) / 1e6,
+            counters.algorithmNs() / 1e6,
+            counters.waitNs.load(std::memory_order_relaxed) / 1e6,
+            counters.emitNs.load(std::memory_order_relaxed) / 1e6,
+        };
+    }
+
+    QDialog *dialog = new QDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->setWindowTitle("Run summary");
+
+    QTableWidget *table = new QTableWidget(int(rows.size()), int(headers.size()), dialog);
+    table->setHorizontalHeaderLabels(headers);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->verticalHeader()->hide();
+    for (int row = 0; row < rows.size(); ++row) {
+        for (int column = 0; column < headers.size(); ++column) {
+            // Numbers stay numbers, so clicking a header sorts them numerically
+            QTableWidgetItem *item = new QTableWidgetItem();
+            item->setData(Qt::DisplayRole, rows[row][column]);
+            table->setItem(row, column, item);
+        }
+    }
+    table->setSortingEnabled(true);
+    table->resizeColumnsToContents();
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, dialog);
+    QPushButton *exportButton = buttons->addButton("Export CSV...", QDialogButtonBox::ActionRole);
+    connect(buttons, &QDialogButtonBox::rejected, dialog, &QDialog::close);
+    connect(exportButton, &QPushButton::clicked, dialog, [dialog, csvHeaders, rows]() {
+        const QString path = QFileDialog::getSaveFileName(dialog, "Export summary", QString(), "CSV files (*.csv)");
+        if (path.isEmpty()) {
+            return;
+        }
+
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            QMessageBox::warning(dialog, "Export summary", QString("Could not write %1").arg(path));
+            return;
+        }
+        QTextStream out(&file);
+        out << csvHeaders.join(',') << '\n';
+        for (const QVariantList &row : rows) {
+            QStringList fields;
+            fields << QString("\"%1\"").arg(row[0].toString());
+            for (int column = 1; column < row.size(); ++column) {
+                fields << (row[column].typeId() == QMetaType::Double ? QString::number(row[column].toDouble(), 'f', 3)
+                                                                     : row[column].toString());
+            }
+            out << fields.join(',') << '\n';
+        }
+    });
+
+    QVBoxLayout *layout = new QVBoxLayout(dialog);
+    layout->addWidget(table);
+    layout->addWidget(buttons);
+    dialog->resize(1100, qMin(800, 80 + 30 * int(rows.size())));
+    dialog->show();
+}
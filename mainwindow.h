@@ -7,6 +7,11 @@
 #include <QtCharts/QBarSeries>
 #include <QtCharts/QBarSet>
 #include "worker.h"
+#include "workerpool.h"
+#include "barview.h"
+#include "traceplayer.h"
+#include <QElapsedTimer>
+#include <QLabel>
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -31,38 +36,125 @@ private slots:
     void on_stopButton_clicked();
     void on_speedSlider_valueChanged(int value);
     void on_comboBox_activated(int index);
+    void on_rendererComboBox_currentIndexChanged(int index);
     void process();
     void on_clearAlgoButton_clicked();
-    QVector<int> generateRandomVector(int size);
+    void on_compareGapsButton_clicked();
+    void on_compareHeapsButton_clicked();
     void finishSorting(int index);
 
-    void updateChartDuringSort(int chartIndex, const QVector<int> &data);
+    void updateChartDuringSort(int chartIndex, const QVector<SortStep> &steps);
+    void renderFrame();
+
+    // Record & replay
+    void onTraceReady(int chartIndex, const QSharedPointer<TraceSource> &trace);
+    void on_modeComboBox_currentIndexChanged(int index);
+    void on_playPauseButton_clicked();
+    void on_stepBackButton_clicked();
+    void on_stepForwardButton_clicked();
+    void on_seekSlider_sliderMoved(int position);
+    void on_saveTracesButton_clicked();
+    void on_loadTraceButton_clicked();
+
+    // Input data
+    void on_generateButton_clicked();
+    void on_loadDataButton_clicked();
+    void on_saveDataButton_clicked();
 
 private:
     Ui::MainWindow *ui;
-    // stopwatch variables
+    // stopwatch: wall-clock time of the current run without pauses; timer only refreshes the display
     QTimer timer;
-    short int milliseconds;
-    short int seconds;
-    short int minutes;
+    QElapsedTimer stopwatch;    // Running stretch, invalid while stopped
+    qint64 stopwatchBankedMs = 0; // Stretches before the last pause
+    static constexpr int StopwatchRefreshMs = 31;
+    void startStopwatch();
+    void stopStopwatch();
+    void resetStopwatch();
     //shared vector
     QVector<int> sharedRandomVector;
+    quint64 dataSeed = 0; // Seed the shared vector was generated with (0 for loaded files), stored in trace files
+    // Use values as the input of every chart that is not sorting
+    void setSharedData(const QVector<int> &values, quint64 seed);
+    // Qt Charts draws one item per bar, larger inputs switch to the fast renderer
+    static constexpr int MaxChartBars = 2000;
     // CHARTS
-    QChartView *chartViews[6];
-    QChart *charts[6];
-    QBarSeries *barSeries[6];
-    bool chartOccupied[6] = {false, false, false, false, false, false};
-    void setupChartsGrid();
+    // One chart per algorithm added, created on demand and laid out in a near-square grid
+    struct ChartSlot
+    {
+        QString algorithm;
+        int algorithmId = -1; // Registry index, -1 when the chart has none the Worker can run
+        QChartView *chartView = nullptr;
+        QChart *chart = nullptr;
+        QBarSeries *barSeries = nullptr;
+        QLabel *statsLabel = nullptr; // Counter overlay of the QtCharts view
+        // The chart's own copy of the array, kept in sync by applying worker steps
+        QVector<int> data;
+        bool dirty = false; // Data changed since the last frame
+        // Indices touched by the latest steps, drawn highlighted by the fast renderer
+        QVector<int> highlights;
+        // Pool thread + 1 that last handled each element, only kept for parallel algorithms
+        QVector<quint8> owners;
+        // Live operation counters of the run, drawn over the chart while it sorts
+        QSharedPointer<sorting::SortCounters> counters;
+        Worker *worker = nullptr; // Pool worker sorting for the chart, null when idle
+        // Shared with the run's job, kept after the worker has moved on
+        QSharedPointer<RunToken> runToken;
+        bool queued = false; // Waiting for a free run slot
+        TracePlayer player;
+        bool playbackFinished = false;
+    };
+    QVector<ChartSlot> charts;
+    static constexpr int MaxCharts = 64;
+    // QtCharts creates a graphics scene per chart; more charts than this switch to the fast renderer
+    static constexpr int MaxChartViews = 12;
+    // All charts drawn by one widget, shown instead of the chart views when selected
+    BarView *barView = nullptr;
+    bool useFastBars = false;
+    // Repaints dirty charts at most once per display frame
+    QTimer renderTimer;
+    static constexpr int FrameIntervalMs = 16; // ~60 Hz
+    int addChart(const QString &algorithm, int algorithmId);
+    void removeCharts();
+    void addAlgorithms(SortAlgorithm first, SortAlgorithm last, const QString &title);
+    void layoutCharts();
     void updateChart(int index, const QVector<int> &values, const QString &algorithm);
+    void setChartTitle(int index, const QString &title);
+    void clearChart(int index);
+    QTimer statsTimer;
+    static constexpr int StatsIntervalMs = 100;
+    void updateStats();
+    // Table of every finished chart's counters
+    void showSummary();
+    void clearStats(int index);
 
-    // Keep track of assigned algorithms for each chart
-    QString assignedAlgorithms[6];
-
-    // Arrays to store threads and workers for each chart
-    int activeWorkers = 0;
+    // Runs go to a fixed pool of workers, one per core; the other charts wait in line and start
+    // as workers come back
+    WorkerPool *workerPool = nullptr;
+    int activeWorkers = 0; // Charts with a worker, not counting cancelled runs still winding down
+    QList<int> queuedCharts;
+    void startQueuedRuns();
+    void startRun(int index, Worker *worker);
+    void onWorkerFinished(Worker *worker);
+    void runFinished(int index);
+    bool isRunning() const { return activeWorkers > 0 || !queuedCharts.isEmpty(); }
+    bool runsPaused = false;
+    void setRunsPaused(bool paused);
 
-    QThread* threads[6] = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
-    Worker* workers[6] = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+    // Record & replay: workers record a trace at full speed, then all charts play back in lockstep
+    bool replayMode = false;
+    bool playing = false;
+    int playbackPosition = 0;
+    int playbackLength = 0; // Longest trace
+    double playbackCarry = 0.0; // Fractional steps left over from the previous frame
+    QElapsedTimer frameClock;
+    void startPlayback();
+    void seekPlayback(int position);
+    void advancePlayback();
+    void setPlaying(bool play);
+    void resetPlayback();
+    double playbackStepsPerSecond() const;
+    QString traceFilePath(int index) const;
 
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,55 @@
+#include "pacingscheduler.h"
+#include <cmath>
+
+PacingScheduler::PacingScheduler() : m_epoch(Clock::now())
+{
+}
+
+PacingScheduler &PacingScheduler::global()
+{
+    static PacingScheduler scheduler;
+    return scheduler;
+}
+
+double PacingScheduler::stepsPerSecond(int speed)
+{
+    if (speed >= 100) {
+        return 0.0;
+    }
+    speed = std::max(1, speed);
+    return std::pow(10.0, (speed - 1) * 6.0 / 98.0);
+}
+
+long long PacingScheduler::currentTick() const
+{
+    return (Clock::now() - m_epoch) / TickInterval;
+}
+
+void PacingScheduler::waitForTick(long long tick)
+{
+    // A wakeAll() that slips in before the wait is only missed until the tick starts
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wake.wait_until(lock, m_epoch + tick * TickInterval);
+}
+
+void PacingScheduler::wakeAll()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_wake.notify_all();
+}
+
+//////////////////////////
+// Lane
+//////////////////////////
+PacingScheduler::Lane::Lane(PacingScheduler &scheduler)
+    : m_scheduler(scheduler), m_tick(scheduler.currentTick())
+{
+}
+
+void PacingScheduler::Lane::setRate(double stepsPerSecond)
+{
+    m_rate.store(std::max(0.0, stepsPerSecond), std::memory_order_relaxed);
+    m_scheduler.wakeAll();
+}
@@ -0,0 +1,100 @@
+#ifndef PACINGSCHEDULER_H
+#define PACINGSCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Paces the live workers by step budgets instead of a fixed sleep per step.
+// Time is cut into ticks shared by every worker. Each worker owns a Lane with a rate in steps
+// per second; every tick grants the lane rate * TickInterval steps, and a lane that has spent
+// its budget blocks until the tick that pays it back. Fast rates spend thousands of steps per
+// tick and only wait once per tick, slow rates wait several ticks per step. Rates can change
+// at any time and take effect at the next step.
+class PacingScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::chrono::milliseconds TickInterval{10};
+
+    PacingScheduler();
+
+    PacingScheduler(const PacingScheduler &) = delete;
+    PacingScheduler &operator=(const PacingScheduler &) = delete;
+
+    // Scheduler shared by the GUI workers
+    static PacingScheduler &global();
+
+    // Speed slider position to steps per second: 1 to 99 cover 1 to 1,000,000 steps per second
+    // on a log scale, 100 (or a rate of 0) means unlimited
+    static double stepsPerSecond(int speed);
+
+    // Ticks since the scheduler was created
+    long long currentTick() const;
+    // Blocks until tick has started or wakeAll() is called
+    void waitForTick(long long tick);
+    // Wakes every waiting lane so it re-reads its rate
+    void wakeAll();
+
+    class Lane
+    {
+    public:
+        explicit Lane(PacingScheduler &scheduler = PacingScheduler::global());
+
+        // Any thread; 0 is unlimited
+        void setRate(double stepsPerSecond);
+        double rate() const { return m_rate.load(std::memory_order_relaxed); }
+
+        // Spends cost steps of the budget, false when it ran out and the caller has to wait()
+        bool spend(int cost)
+        {
+            if (rate() <= 0.0) {
+                return true;
+            }
+            m_budget -= cost;
+            return m_budget >= 0.0;
+        }
+
+        // Blocks until the budget is paid back, the lane turns unlimited or stop() returns true.
+        // stop() is checked at least once per tick.
+        template <typename Stop>
+        void wait(const Stop &stop)
+        {
+            while (!stop()) {
+                const double stepsPerSecond = rate();
+                if (stepsPerSecond <= 0.0) {
+                    m_budget = 0.0;
+                    return;
+                }
+
+                const long long tick = m_scheduler.currentTick();
+                if (tick > m_tick) {
+                    // Unused budget is not carried over idle ticks, so a stalled worker doesn't burst
+                    const double perTick = stepsPerSecond * std::chrono::duration<double>(TickInterval).count();
+                    m_budget = std::min(m_budget + double(tick - m_tick) * perTick, perTick);
+                    m_tick = tick;
+                    if (m_budget >= 0.0) {
+                        return;
+                    }
+                }
+                m_scheduler.waitForTick(m_tick + 1);
+            }
+        }
+
+    private:
+        PacingScheduler &m_scheduler;
+        std::atomic<double> m_rate{0.0};
+        // Only touched by the thread that spends, or by callers serialized around it
+        double m_budget = 0.0;
+        long long m_tick = 0;
+    };
+
+private:
+    Clock::time_point m_epoch;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+};
+
+#endif // PACINGSCHEDULER_H
@@ -0,0 +1,519 @@
+#ifndef PARALLELSORT_H
+#define PARALLELSORT_H
+
+#include <algorithm>
+#include <mutex>
+#include <type_traits>
+#include "sortkernels.h"
+#include "workstealingpool.h"
+
+// Parallel divide-and-conquer sorts on a WorkStealingPool.
+// Observer calls can come from several threads at once; observers that are not thread-safe
+// are wrapped in a SynchronizedObserver. Every segment reports the pool thread handling it
+// through obs.owner(low, high, thread).
+namespace sorting {
+
+template <typename Observer>
+struct ObserverIsThreadSafe : std::false_type {};
+
+template <>
+struct ObserverIsThreadSafe<NullObserver> : std::true_type {};
+
+// Serializes all calls into a single-threaded observer
+template <typename Observer>
+class SynchronizedObserver
+{
+public:
+    explicit SynchronizedObserver(Observer &obs) : m_obs(obs) {}
+
+    void compare(int i, int j) { std::lock_guard<std::mutex> lock(m_mutex); m_obs.compare(i, j); }
+    void swap(int i, int j) { std::lock_guard<std::mutex> lock(m_mutex); m_obs.swap(i, j); }
+    template <typename T>
+    void write(int i, const T &value) { std::lock_guard<std::mutex> lock(m_mutex); m_obs.write(i, value); }
+    void range(int low, int high) { std::lock_guard<std::mutex> lock(m_mutex); m_obs.range(low, high); }
+    void owner(int low, int high, int thread) { std::lock_guard<std::mutex> lock(m_mutex); m_obs.owner(low, high, thread); }
+    void pace() { std::lock_guard<std::mutex> lock(m_mutex); m_obs.pace(); }
+    bool cancelled() const { return m_obs.cancelled(); }
+
+private:
+    Observer &m_obs;
+    std::mutex m_mutex;
+};
+
+template <typename Observer>
+struct ObserverIsThreadSafe<SynchronizedObserver<Observer>> : std::true_type {};
+
+namespace detail {
+
+// Runs body(chunk) for every chunk in [0, chunks) on pool, the calling thread takes the first one
+template <typename Body>
+void forEachChunk(WorkStealingPool &pool, int chunks, Body body)
+{
+    WorkStealingPool::TaskGroup group(pool);
+    for (int chunk = 1; chunk < chunks; ++chunk) {
+        group.run([&body, chunk]() { body(chunk); });
+    }
+    body(0);
+    group.wait();
+}
+
+// Below this many elements a segment is sorted sequentially
+inline int parallelCutoff(int n, int threadCount)
+{
+    return std::max(32, n / (threadCount * 16));
+}
+
+// Merge src[aLow..aHigh] and src[bLow..bHigh] (both sorted) into data starting at dst.
+// Large merges split at the middle of the longer run and binary search the split in the
+// other one, so both halves can be merged in parallel.
+template <typename T, typename Observer>
+void parallelMerge(const T *src, int aLow, int aHigh, int bLow, int bHigh, T *data, int dst,
+                   Observer &obs, WorkStealingPool &pool, int cutoff)
+{
+    const int aCount = aHigh - aLow + 1;
+    const int bCount = bHigh - bLow + 1;
+    if (aCount + bCount == 0) {
+        return;
+    }
+    // data[dst..] was copied out to src and may already be partly overwritten, so a cancelled
+    // run still has to put every element back: finish with a plain merge, unobserved
+    if (obs.cancelled()) {
+        std::merge(src + aLow, src + aHigh + 1, src + bLow, src + bHigh + 1, data + dst);
+        return;
+    }
+
+    if (aCount + bCount <= cutoff) {
+        obs.owner(dst, dst + aCount + bCount - 1, WorkStealingPool::currentThreadIndex());
+        int i = aLow, j = bLow, k = dst;
+        while (i <= aHigh && j <= bHigh) {
+            obs.compare(i, j);
+            if (src[i] <= src[j]) {
+                data[k] = src[i++];
+            }
+            else {
+                data[k] = src[j++];
+            }
+            obs.write(k, data[k]);
+            k++;
+
+            obs.pace();
+        }
+        while (i <= aHigh) {
+            obs.write(k, src[i]);
+            data[k++] = src[i++];
+        }
+        while (j <= bHigh) {
+            obs.write(k, src[j]);
+            data[k++] = src[j++];
+        }
+        return;
+    }
+
+    // Split point: elements equal to the pivot keep the left run first (stable)
+    int aSplit, bSplit;
+    if (aCount >= bCount) {
+        aSplit = aLow + aCount / 2;
+        int low = bLow, high = bHigh + 1; // First b element not less than src[aSplit]
+        while (low < high) {
+            int mid = low + (high - low) / 2;
+            obs.compare(mid, aSplit);
+            if (src[mid] < src[aSplit]) low = mid + 1; else high = mid;
+        }
+        bSplit = low;
+    }
+    else {
+        bSplit = bLow + bCount / 2;
+        int low = aLow, high = aHigh + 1; // First a element greater than src[bSplit]
+        while (low < high) {
+            int mid = low + (high - low) / 2;
+            obs.compare(mid, bSplit);
+            if (src[mid] <= src[bSplit]) low = mid + 1; else high = mid;
+        }
+        aSplit = low;
+    }
+
+    const int leftCount = (aSplit - aLow) + (bSplit - bLow);
+    WorkStealingPool::TaskGroup group(pool);
+    group.run([=, &obs, &pool]() {
+        parallelMerge(src, aLow, aSplit - 1, bLow, bSplit - 1, data, dst, obs, pool, cutoff);
+    });
+    parallelMerge(src, aSplit, aHigh, bSplit, bHigh, data, dst + leftCount, obs, pool, cutoff);
+    group.wait();
+}
+
+template <typename T, typename Observer>
+void parallelMergeSortRecursive(T *data, T *scratch, int left, int right, Observer &obs,
+                                WorkStealingPool &pool, int cutoff)
+{
+    if (left >= right || obs.cancelled()) {
+        return;
+    }
+
+    obs.owner(left, right, WorkStealingPool::currentThreadIndex());
+    if (right - left + 1 <= cutoff) {
+        mergeSortRecursive(data, scratch, left, right, obs);
+        return;
+    }
+
+    int mid = left + (right - left) / 2;
+    {
+        WorkStealingPool::TaskGroup group(pool);
+        group.run([=, &obs, &pool]() {
+            parallelMergeSortRecursive(data, scratch, left, mid, obs, pool, cutoff);
+        });
+        parallelMergeSortRecursive(data, scratch, mid + 1, right, obs, pool, cutoff);
+    }
+
+    // Merge from a copy of both halves straight back into place
+    std::copy(data + left, data + right + 1, scratch + left);
+    parallelMerge(scratch, left, mid, mid + 1, right, data, left, obs, pool, cutoff);
+}
+
+// Hoare partition around the median of the first, middle and last element.
+// Returns j such that [low, j] <= pivot <= [j + 1, high].
+template <typename T, typename Observer>
+int medianOfThreePartition(T *data, int low, int high, Observer &obs)
+{
+    int mid = low + (high - low) / 2;
+    obs.compare(mid, low);
+    if (data[mid] < data[low]) { std::swap(data[mid], data[low]); obs.swap(mid, low); }
+    obs.compare(high, low);
+    if (data[high] < data[low]) { std::swap(data[high], data[low]); obs.swap(high, low); }
+    obs.compare(high, mid);
+    if (data[high] < data[mid]) { std::swap(data[high], data[mid]); obs.swap(high, mid); }
+    T pivot = data[mid];
+
+    obs.range(low, high);
+
+    int i = low - 1;
+    int j = high + 1;
+    while (true) {
+        do {
+            i++;
+            obs.compare(i, mid);
+        } while (data[i] < pivot);
+        do {
+            j--;
+            obs.compare(j, mid);
+        } while (data[j] > pivot);
+
+        if (i >= j) {
+            return j;
+        }
+        std::swap(data[i], data[j]);
+        obs.swap(i, j);
+    }
+}
+
+template <typename T, typename Observer>
+void parallelQuickSortRecursive(T *data, int low, int high, Observer &obs, WorkStealingPool &pool, int cutoff)
+{
+    WorkStealingPool::TaskGroup group(pool);
+
+    // Fork the smaller side, keep looping on the larger one
+    while (low < high && !obs.cancelled()) {
+        obs.owner(low, high, WorkStealingPool::currentThreadIndex());
+
+        int split = medianOfThreePartition(data, low, high, obs);
+        obs.pace();
+
+        int leftLow = low, leftHigh = split;
+        int rightLow = split + 1, rightHigh = high;
+        if (leftHigh - leftLow > rightHigh - rightLow) {
+            std::swap(leftLow, rightLow);
+            std::swap(leftHigh, rightHigh);
+        }
+
+        if (leftHigh - leftLow + 1 > cutoff) {
+            group.run([=, &obs, &pool]() {
+                parallelQuickSortRecursive(data, leftLow, leftHigh, obs, pool, cutoff);
+            });
+        }
+        else {
+            // Small sides stay on this thread; recursing on the smaller side bounds the depth
+            parallelQuickSortRecursive(data, leftLow, leftHigh, obs, pool, cutoff);
+        }
+
+        low = rightLow;
+        high = rightHigh;
+    }
+
+    group.wait();
+}
+
+} // namespace detail
+
+//////////////////////////
+// Parallel Merge Sort
+//////////////////////////
+template <typename T, typename Observer>
+void parallelMergeSort(T *data, int n, Observer &obs, WorkStealingPool &pool = WorkStealingPool::global(),
+                       SortArena &arena = SortArena::threadLocal())
+{
+    if (n < 2) {
+        return;
+    }
+
+    if constexpr (ObserverIsThreadSafe<Observer>::value) {
+        SortArena::Scope scope(arena);
+        T *scratch = arena.allocate<T>(n);
+        detail::parallelMergeSortRecursive(data, scratch, 0, n - 1, obs, pool,
+                                           detail::parallelCutoff(n, pool.threadCount()));
+    }
+    else {
+        SynchronizedObserver<Observer> synchronized(obs);
+        parallelMergeSort(data, n, synchronized, pool, arena);
+    }
+}
+
+//////////////////////////
+// Parallel Quick Sort
+//////////////////////////
+template <typename T, typename Observer>
+void parallelQuickSort(T *data, int n, Observer &obs, WorkStealingPool &pool = WorkStealingPool::global())
+{
+    if (n < 2) {
+        return;
+    }
+
+    if constexpr (ObserverIsThreadSafe<Observer>::value) {
+        detail::parallelQuickSortRecursive(data, 0, n - 1, obs, pool,
+                                           detail::parallelCutoff(n, pool.threadCount()));
+    }
+    else {
+        SynchronizedObserver<Observer> synchronized(obs);
+        parallelQuickSort(data, n, synchronized, pool);
+    }
+}
+
+//////////////////////////
+// Parallel Radix Sort
+//////////////////////////
+// LSD radix sort with the array split into one chunk per thread. Every chunk gets its own
+// histogram, so each thread scatters its chunk to positions no other thread writes. The
+// first pass uses the all-digit histograms from the initial read; later passes count their
+// digit again per chunk, since the chunks then hold different elements.
+template <int DigitBits, typename T, typename Observer>
+void parallelRadixSort(T *data, int n, Observer &obs, WorkStealingPool &pool = WorkStealingPool::global(),
+                       SortArena &arena = SortArena::threadLocal())
+{
+    constexpr int Radix = 1 << DigitBits;
+    constexpr int Passes = detail::radixPassCount<T, DigitBits>();
+    constexpr int MinChunkSize = 1 << 16; // Smaller chunks cost more in histograms than they gain
+
+    if (n < 2) {
+        return;
+    }
+
+    if constexpr (!ObserverIsThreadSafe<Observer>::value) {
+        SynchronizedObserver<Observer> synchronized(obs);
+        parallelRadixSort<DigitBits>(data, n, synchronized, pool, arena);
+    }
+    else {
+        const int chunks = std::max(1, std::min(pool.threadCount(), n / MinChunkSize));
+        auto chunkBegin = [n, chunks](int chunk) { return int((long long)n * chunk / chunks); };
+
+        auto forEachChunk = [&pool, chunks](auto body) { detail::forEachChunk(pool, chunks, body); };
+
+        SortArena::Scope scope(arena);
+        const std::size_t histogramSize = std::size_t(Passes) * Radix;
+        unsigned *counts = arena.allocate<unsigned>(histogramSize * chunks); // Per chunk, every pass
+        unsigned *totals = arena.allocate<unsigned>(histogramSize);
+        std::fill(counts, counts + histogramSize * chunks, 0u);
+        std::fill(totals, totals + histogramSize, 0u);
+
+        forEachChunk([&](int chunk) {
+            detail::radixHistograms<DigitBits>(data, chunkBegin(chunk), chunkBegin(chunk + 1),
+                                               counts + histogramSize * chunk);
+        });
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            for (std::size_t i = 0; i < histogramSize; ++i) {
+                totals[i] += counts[histogramSize * chunk + i];
+            }
+        }
+
+        T *src = data;
+        T *dst = arena.allocate<T>(n);
+        bool firstPass = true;
+        for (int pass = 0; pass < Passes && !obs.cancelled(); ++pass) {
+            const unsigned *total = totals + (pass << DigitBits);
+            if (total[detail::radixDigit<DigitBits>(RadixKey<T>::toKey(src[0]), pass)] == unsigned(n)) {
+                continue; // Every key has the same digit here, nothing would move
+            }
+
+            // Per chunk counts of this pass's digit in the current order
+            auto chunkCounts = [&](int chunk) { return counts + histogramSize * chunk + (pass << DigitBits); };
+            if (!firstPass) {
+                forEachChunk([&](int chunk) {
+                    unsigned *count = chunkCounts(chunk);
+                    std::fill(count, count + Radix, 0u);
+                    for (int i = chunkBegin(chunk); i < chunkBegin(chunk + 1); ++i) {
+                        count[detail::radixDigit<DigitBits>(RadixKey<T>::toKey(src[i]), pass)]++;
+                    }
+                });
+            }
+            firstPass = false;
+
+            // Starting positions: digit-major, then chunk order, which keeps the sort stable
+            unsigned sum = 0;
+            for (int digit = 0; digit < Radix; ++digit) {
+                for (int chunk = 0; chunk < chunks; ++chunk) {
+                    unsigned &count = chunkCounts(chunk)[digit];
+                    const unsigned start = sum;
+                    sum += count;
+                    count = start;
+                }
+            }
+
+            obs.range(0, n - 1);
+            forEachChunk([&](int chunk) {
+                unsigned *offsets = chunkCounts(chunk);
+                const int begin = chunkBegin(chunk);
+                const int end = chunkBegin(chunk + 1);
+                obs.owner(begin, end - 1, WorkStealingPool::currentThreadIndex());
+                for (int i = begin; i < end && !obs.cancelled(); ++i) {
+                    const int position = int(offsets[detail::radixDigit<DigitBits>(RadixKey<T>::toKey(src[i]), pass)]++);
+                    dst[position] = src[i];
+                    obs.write(position, src[i]);
+
+                    obs.pace();
+                }
+            });
+            if (obs.cancelled()) {
+                break; // src still holds every element
+            }
+            std::swap(src, dst);
+        }
+
+        if (src != data) {
+            std::copy(src, src + n, data);
+        }
+    }
+}
+
+//////////////////////////
+// Parallel Counting Sort
+//////////////////////////
+// Counting sort split like parallelRadixSort: every chunk counts its keys into a histogram of
+// its own, a parallel prefix sum turns all histograms into starting positions, key-major and
+// then chunk order, which keeps the sort stable, and every chunk scatters its elements without
+// locks. The histograms share countingSort's budget, so wide key ranges use fewer chunks, and
+// ranges the budget can't count at all go to parallel radix sort.
+template <typename T, typename Observer>
+void parallelCountingSort(T *data, int n, Observer &obs, WorkStealingPool &pool = WorkStealingPool::global(),
+                          SortArena &arena = SortArena::threadLocal())
+{
+    using Key = typename SortKey<T>::Type;
+    constexpr int MinChunkSize = 1 << 16;
+
+    if (n < 2) {
+        return;
+    }
+
+    if constexpr (!ObserverIsThreadSafe<Observer>::value) {
+        SynchronizedObserver<Observer> synchronized(obs);
+        parallelCountingSort(data, n, synchronized, pool, arena);
+    }
+    else if constexpr (!std::is_integral<Key>::value) {
+        parallelRadixSort<8>(data, n, obs, pool, arena);
+    }
+    else {
+        int chunks = std::max(1, std::min(pool.threadCount(), n / MinChunkSize));
+        auto chunkBegin = [n, &chunks](int chunk) { return int((long long)n * chunk / chunks); };
+
+        // Smallest and largest key of every chunk, then of all of them
+        SortArena::Scope scope(arena);
+        Key *minima = arena.allocate<Key>(chunks);
+        Key *maxima = arena.allocate<Key>(chunks);
+        detail::forEachChunk(pool, chunks, [&](int chunk) {
+            const auto extremes = std::minmax_element(data + chunkBegin(chunk), data + chunkBegin(chunk + 1));
+            minima[chunk] = SortKey<T>::get(*extremes.first);
+            maxima[chunk] = SortKey<T>::get(*extremes.second);
+        });
+        const Key min = *std::min_element(minima, minima + chunks);
+        const Key max = *std::max_element(maxima, maxima + chunks);
+
+        const unsigned long long span = detail::keySpan(min, max);
+        const long long budget = detail::countingBudget(n);
+        if (span >= (unsigned long long)budget) {
+            parallelRadixSort<8>(data, n, obs, pool, arena);
+            return;
+        }
+        const int range = int(span) + 1;
+        chunks = int(std::min<long long>(chunks, budget / range)); // At least 1, range <= budget
+
+        // counts[chunk * range + slot]; each chunk clears and fills its own histogram
+        unsigned *counts = arena.allocate<unsigned>(std::size_t(range) * chunks);
+        detail::forEachChunk(pool, chunks, [&](int chunk) {
+            unsigned *count = counts + std::size_t(range) * chunk;
+            std::fill(count, count + range, 0u);
+            for (int i = chunkBegin(chunk); i < chunkBegin(chunk + 1); ++i) {
+                count[detail::keySpan(min, SortKey<T>::get(data[i]))]++;
+            }
+        });
+        if (obs.cancelled()) {
+            return;
+        }
+
+        // Prefix sum over slot-major, chunk-minor order in three steps: every block of slots
+        // sums its counts, the few block sums are scanned here, then every block rewrites its
+        // counts into starting positions from its block's start
+        const int blocks = chunks;
+        auto blockBegin = [range, blocks](int block) { return int((long long)range * block / blocks); };
+        unsigned *blockStarts = arena.allocate<unsigned>(blocks);
+        detail::forEachChunk(pool, blocks, [&](int block) {
+            unsigned sum = 0;
+            for (int slot = blockBegin(block); slot < blockBegin(block + 1); ++slot) {
+                for (int chunk = 0; chunk < chunks; ++chunk) {
+                    sum += counts[std::size_t(range) * chunk + slot];
+                }
+            }
+            blockStarts[block] = sum;
+        });
+        unsigned sum = 0;
+        for (int block = 0; block < blocks; ++block) {
+            const unsigned blockSum = blockStarts[block];
+            blockStarts[block] = sum;
+            sum += blockSum;
+        }
+        detail::forEachChunk(pool, blocks, [&](int block) {
+            unsigned position = blockStarts[block];
+            for (int slot = blockBegin(block); slot < blockBegin(block + 1); ++slot) {
+                for (int chunk = 0; chunk < chunks; ++chunk) {
+                    unsigned &count = counts[std::size_t(range) * chunk + slot];
+                    const unsigned start = position;
+                    position += count;
+                    count = start;
+                }
+            }
+        });
+
+        T *output = arena.allocate<T>(n);
+        obs.range(0, n - 1);
+        detail::forEachChunk(pool, chunks, [&](int chunk) {
+            unsigned *offsets = counts + std::size_t(range) * chunk;
+            const int begin = chunkBegin(chunk);
+            const int end = chunkBegin(chunk + 1);
+            obs.owner(begin, end - 1, WorkStealingPool::currentThreadIndex());
+            for (int i = begin; i < end && !obs.cancelled(); ++i) {
+                const int position = int(offsets[detail::keySpan(min, SortKey<T>::get(data[i]))]++);
+                output[position] = data[i];
+                obs.write(position, data[i]);
+
+                obs.pace();
+            }
+        });
+        if (obs.cancelled()) {
+            return; // data still holds every element
+        }
+
+        // The observer already saw these values written
+        detail::forEachChunk(pool, chunks, [&](int chunk) {
+            std::copy(output + chunkBegin(chunk), output + chunkBegin(chunk + 1), data + chunkBegin(chunk));
+        });
+    }
+}
+
+} // namespace sorting
+
+#endif // PARALLELSORT_H
@@ -0,0 +1,64 @@
+#ifndef RUNTOKEN_H
+#define RUNTOKEN_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// Cancellation and pause for one sorting run. Any thread may cancel, pause or resume; the run
+// only looks at the token at coarse points. Kernels test isCancelled() through their observer
+// once per outer loop iteration, and observers call checkpoint() where they already stop for
+// pacing, so inner loops carry no synchronization at all.
+class RunToken
+{
+public:
+    // Final: a cancelled run cannot be resumed
+    void cancel()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_state.store(Cancelled, std::memory_order_relaxed);
+        }
+        m_resumed.notify_all();
+    }
+
+    void pause()
+    {
+        int expected = Running;
+        m_state.compare_exchange_strong(expected, Paused, std::memory_order_relaxed);
+    }
+
+    void resume()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            int expected = Paused;
+            m_state.compare_exchange_strong(expected, Running, std::memory_order_relaxed);
+        }
+        m_resumed.notify_all();
+    }
+
+    bool isCancelled() const { return m_state.load(std::memory_order_relaxed) == Cancelled; }
+    bool isPaused() const { return m_state.load(std::memory_order_relaxed) == Paused; }
+
+    // Blocks while paused, false once the run is cancelled
+    bool checkpoint()
+    {
+        if (m_state.load(std::memory_order_relaxed) == Running) {
+            return true;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_resumed.wait(lock, [this]() { return m_state.load(std::memory_order_relaxed) != Paused; });
+        return m_state.load(std::memory_order_relaxed) == Running;
+    }
+
+private:
+    enum State { Running, Paused, Cancelled };
+
+    std::atomic<int> m_state{Running};
+    std::mutex m_mutex;
+    std::condition_variable m_resumed;
+};
+
+#endif // RUNTOKEN_H
@@ -0,0 +1,717 @@
+#include "simdsort.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SORTING_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SORTING_TARGET_AVX2
+#else
+// AVX2 code is compiled for this function only, the rest of the program stays baseline x86
+#define SORTING_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace sorting {
+namespace simd {
+
+namespace {
+
+constexpr int SmallSortSize = 64; // Largest range sortSmall handles, multiple of every lane count
+constexpr int ReportBlock = 8;    // Elements per BlockSink call from the scalar parts
+
+struct Kernels
+{
+    // Reorder [low, high] so elements <= bound come first, returns the index of the first larger one
+    int (*partition)(int *data, int low, int high, int bound, BlockSink *sink);
+    // Sort count <= SmallSortSize elements starting at low
+    void (*sortSmall)(int *data, int low, int count, BlockSink *sink);
+    // Merge src[left..mid] and src[mid + 1..right] into dst[left..right]
+    void (*merge)(const int *src, int left, int mid, int right, int *dst, BlockSink *sink);
+};
+
+void reportRange(const int *data, int low, int high, BlockSink *sink)
+{
+    if (!sink) {
+        return;
+    }
+    for (int i = low; i <= high; i += ReportBlock) {
+        sink->blockWritten(i, std::min(ReportBlock, high - i + 1), data + i);
+    }
+}
+
+int *mergeScalar(const int *a, const int *aEnd, const int *b, const int *bEnd, int *out)
+{
+    while (a != aEnd && b != bEnd) {
+        *out++ = (*b < *a) ? *b++ : *a++;
+    }
+    out = std::copy(a, aEnd, out);
+    return std::copy(b, bEnd, out);
+}
+
+// Elements <= bound go left, the rest right. Lane orders for every compare mask.
+template <int Lanes>
+struct PartitionTable
+{
+    std::uint8_t order[1 << Lanes][Lanes]; // Lanes going left first, then lanes going right
+    std::uint8_t leftCount[1 << Lanes];
+};
+
+template <int Lanes>
+constexpr PartitionTable<Lanes> makePartitionTable()
+{
+    PartitionTable<Lanes> table{};
+    for (int mask = 0; mask < (1 << Lanes); ++mask) {
+        int k = 0;
+        for (int lane = 0; lane < Lanes; ++lane) {
+            if (!(mask & (1 << lane))) {
+                table.order[mask][k++] = std::uint8_t(lane);
+            }
+        }
+        table.leftCount[mask] = std::uint8_t(k);
+        for (int lane = 0; lane < Lanes; ++lane) {
+            if (mask & (1 << lane)) {
+                table.order[mask][k++] = std::uint8_t(lane);
+            }
+        }
+    }
+    return table;
+}
+
+// Final elements of a vector partition, placed one at a time at both ends
+inline void placeScalar(int *a, const int *values, int count, int bound, int &wl, int &wr)
+{
+    for (int i = 0; i < count; ++i) {
+        if (values[i] <= bound) {
+            a[wl++] = values[i];
+        }
+        else {
+            a[--wr] = values[i];
+        }
+    }
+}
+
+//////////////////////////
+// Scalar kernels
+//////////////////////////
+int scalarPartition(int *data, int low, int high, int bound, BlockSink *sink)
+{
+    int i = low;
+    for (int j = low; j <= high; ++j) {
+        if (data[j] <= bound) {
+            std::swap(data[i++], data[j]);
+        }
+    }
+    reportRange(data, low, high, sink);
+    return i;
+}
+
+void scalarSortSmall(int *data, int low, int count, BlockSink *sink)
+{
+    for (int i = low + 1; i < low + count; ++i) {
+        const int key = data[i];
+        int j = i - 1;
+        while (j >= low && data[j] > key) {
+            data[j + 1] = data[j];
+            j--;
+        }
+        data[j + 1] = key;
+    }
+    reportRange(data, low, low + count - 1, sink);
+}
+
+void scalarMerge(const int *src, int left, int mid, int right, int *dst, BlockSink *sink)
+{
+    mergeScalar(src + left, src + mid + 1, src + mid + 1, src + right + 1, dst + left);
+    reportRange(dst, left, right, sink);
+}
+
+const Kernels scalarKernels = {scalarPartition, scalarSortSmall, scalarMerge};
+
+#ifdef SORTING_SIMD_X86
+
+//////////////////////////
+// SSE2 kernels (4 lanes)
+//////////////////////////
+// SSE2 has no 32-bit min/max or blend, they are built from compares and masks
+inline __m128i select4(__m128i mask, __m128i ifSet, __m128i ifClear)
+{
+    return _mm_or_si128(_mm_and_si128(mask, ifSet), _mm_andnot_si128(mask, ifClear));
+}
+
+inline __m128i min4(__m128i a, __m128i b)
+{
+    return select4(_mm_cmpgt_epi32(a, b), b, a);
+}
+
+inline __m128i max4(__m128i a, __m128i b)
+{
+    return select4(_mm_cmpgt_epi32(a, b), a, b);
+}
+
+// Compare every lane with the lane Shuffle moves onto it; lanes in MaxMask keep the larger value
+template <int Shuffle, int MaxMask>
+inline __m128i exchange4(__m128i v)
+{
+    const __m128i partner = _mm_shuffle_epi32(v, Shuffle);
+    const __m128i takeMax = _mm_set_epi32((MaxMask & 8) ? -1 : 0, (MaxMask & 4) ? -1 : 0,
+                                          (MaxMask & 2) ? -1 : 0, (MaxMask & 1) ? -1 : 0);
+    return select4(takeMax, max4(v, partner), min4(v, partner));
+}
+
+constexpr int Swap1x4 = _MM_SHUFFLE(2, 3, 0, 1); // Lane i with lane i ^ 1
+constexpr int Swap2x4 = _MM_SHUFFLE(1, 0, 3, 2); // Lane i with lane i ^ 2
+
+// Bitonic sorting network for one register
+inline __m128i sort4(__m128i v)
+{
+    v = exchange4<Swap1x4, 0x6>(v);
+    v = exchange4<Swap2x4, 0xC>(v);
+    return exchange4<Swap1x4, 0xA>(v);
+}
+
+// Sorted a and b in, the 4 smallest out in a and the 4 largest in b, both sorted
+inline void merge4(__m128i &a, __m128i &b)
+{
+    const __m128i reversed = _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 1, 2, 3));
+    __m128i low = min4(a, reversed);
+    __m128i high = max4(a, reversed);
+    low = exchange4<Swap2x4, 0xC>(low);
+    high = exchange4<Swap2x4, 0xC>(high);
+    a = exchange4<Swap1x4, 0xA>(low);
+    b = exchange4<Swap1x4, 0xA>(high);
+}
+
+constexpr PartitionTable<4> partitionTable4 = makePartitionTable<4>();
+
+int sse2Partition(int *data, int low, int high, int bound, BlockSink *sink)
+{
+    const int n = high - low + 1;
+    if (n < 2 * 4) {
+        return scalarPartition(data, low, high, bound, sink);
+    }
+
+    int *a = data + low;
+    const __m128i pivot = _mm_set1_epi32(bound);
+    alignas(16) int buffered[8];
+    _mm_store_si128(reinterpret_cast<__m128i *>(buffered), _mm_loadu_si128(reinterpret_cast<const __m128i *>(a)));
+    _mm_store_si128(reinterpret_cast<__m128i *>(buffered + 4), _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + n - 4)));
+
+    // The two buffered vectors leave 4 free slots at each end: reads never get overwritten
+    int l = 4, r = n - 4, wl = 0, wr = n;
+    alignas(16) int lanes[4];
+    while (r - l >= 4) {
+        __m128i v;
+        if (l - wl <= wr - r) {
+            v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + l));
+            l += 4;
+        }
+        else {
+            r -= 4;
+            v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + r));
+        }
+
+        // Compare in the register, there is no variable shuffle before SSSE3: place lanes by table
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, pivot)));
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), v);
+        const std::uint8_t *order = partitionTable4.order[mask];
+        for (int k = 0; k < 4; ++k) {
+            a[wl + k] = lanes[order[k]];
+            a[wr - 4 + k] = lanes[order[k]];
+        }
+        if (sink) {
+            sink->blockWritten(low + wl, 4, a + wl);
+            sink->blockWritten(low + wr - 4, 4, a + wr - 4);
+        }
+        const int left = partitionTable4.leftCount[mask];
+        wl += left;
+        wr -= 4 - left;
+    }
+
+    const int start = wl, end = wr;
+    int rest[4];
+    const int restCount = r - l;
+    std::copy(a + l, a + r, rest);
+    placeScalar(a, rest, restCount, bound, wl, wr);
+    placeScalar(a, buffered, 8, bound, wl, wr);
+    reportRange(data, low + start, low + end - 1, sink);
+    return low + wl;
+}
+
+void sse2Merge(const int *src, int left, int mid, int right, int *dst, BlockSink *sink)
+{
+    const int *a = src + left;
+    const int *aEnd = src + mid + 1;
+    const int *b = src + mid + 1;
+    const int *bEnd = src + right + 1;
+    int *out = dst + left;
+
+    if (aEnd - a >= 4 && bEnd - b >= 4) {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+        a += 4;
+        b += 4;
+        for (;;) {
+            merge4(low, high);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), low);
+            if (sink) {
+                sink->blockWritten(int(out - dst), 4, out);
+            }
+            out += 4;
+
+            // Everything written so far is <= everything unread; keep the larger half in flight
+            if (aEnd - a < 4 || bEnd - b < 4) {
+                break;
+            }
+            if (*a < *b) {
+                low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+                a += 4;
+            }
+            else {
+                low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+                b += 4;
+            }
+        }
+
+        // Merge the carried vector with the short tail first, then with the long one
+        alignas(16) int carry[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(carry), high);
+        int tail[8];
+        const int *tailEnd;
+        if (aEnd - a < 4) {
+            tailEnd = mergeScalar(carry, carry + 4, a, aEnd, tail);
+            a = b;
+            aEnd = bEnd;
+        }
+        else {
+            tailEnd = mergeScalar(carry, carry + 4, b, bEnd, tail);
+        }
+        mergeScalar(tail, tailEnd, a, aEnd, out);
+        reportRange(dst, int(out - dst), right, sink);
+        return;
+    }
+
+    mergeScalar(a, aEnd, b, bEnd, out);
+    reportRange(dst, left, right, sink);
+}
+
+void sse2SortSmall(int *data, int low, int count, BlockSink *sink)
+{
+    alignas(16) int buffer[SmallSortSize];
+    alignas(16) int temp[SmallSortSize];
+    const int padded = (count + 3) & ~3;
+    std::copy(data + low, data + low + count, buffer);
+    std::fill(buffer + count, buffer + padded, INT_MAX);
+
+    for (int i = 0; i < padded; i += 4) {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(buffer + i));
+        _mm_store_si128(reinterpret_cast<__m128i *>(buffer + i), sort4(v));
+    }
+
+    int *src = buffer;
+    int *dst = temp;
+    for (int width = 4; width < padded; width *= 2) {
+        for (int left = 0; left < padded; left += 2 * width) {
+            const int mid = std::min(left + width, padded) - 1;
+            const int right = std::min(left + 2 * width, padded) - 1;
+            if (mid < right) {
+                sse2Merge(src, left, mid, right, dst, nullptr);
+            }
+            else {
+                std::copy(src + left, src + right + 1, dst + left);
+            }
+        }
+        std::swap(src, dst);
+    }
+
+    std::copy(src, src + count, data + low);
+    reportRange(data, low, low + count - 1, sink);
+}
+
+const Kernels sse2Kernels = {sse2Partition, sse2SortSmall, sse2Merge};
+
+//////////////////////////
+// AVX2 kernels (8 lanes)
+//////////////////////////
+// Compare every lane with lane i ^ Distance; lanes in MaxMask keep the larger value
+template <int Distance, int MaxMask>
+SORTING_TARGET_AVX2 inline __m256i exchange8(__m256i v)
+{
+    const __m256i index = (Distance == 1)   ? _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6)
+                          : (Distance == 2) ? _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5)
+                                            : _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3);
+    const __m256i partner = _mm256_permutevar8x32_epi32(v, index);
+    return _mm256_blend_epi32(_mm256_min_epi32(v, partner), _mm256_max_epi32(v, partner), MaxMask);
+}
+
+// Bitonic sorting network for one register: 6 compare-exchange stages
+SORTING_TARGET_AVX2 inline __m256i sort8(__m256i v)
+{
+    v = exchange8<1, 0x66>(v);
+    v = exchange8<2, 0x3C>(v);
+    v = exchange8<1, 0x5A>(v);
+    v = exchange8<4, 0xF0>(v);
+    v = exchange8<2, 0xCC>(v);
+    return exchange8<1, 0xAA>(v);
+}
+
+// Sorted a and b in, the 8 smallest out in a and the 8 largest in b, both sorted
+SORTING_TARGET_AVX2 inline void merge8(__m256i &a, __m256i &b)
+{
+    const __m256i reversed = _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    __m256i low = _mm256_min_epi32(a, reversed);
+    __m256i high = _mm256_max_epi32(a, reversed);
+    low = exchange8<4, 0xF0>(low);
+    high = exchange8<4, 0xF0>(high);
+    low = exchange8<2, 0xCC>(low);
+    high = exchange8<2, 0xCC>(high);
+    a = exchange8<1, 0xAA>(low);
+    b = exchange8<1, 0xAA>(high);
+}
+
+constexpr PartitionTable<8> partitionTable8 = makePartitionTable<8>();
+
+SORTING_TARGET_AVX2 int avx2Partition(int *data, int low, int high, int bound, BlockSink *sink)
+{
+    const int n = high - low + 1;
+    if (n < 2 * 8) {
+        return scalarPartition(data, low, high, bound, sink);
+    }
+
+    int *a = data + low;
+    const __m256i pivot = _mm256_set1_epi32(bound);
+    alignas(32) int buffered[16];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(buffered), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a)));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(buffered + 8),
+                       _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + n - 8)));
+
+    // The two buffered vectors leave 8 free slots at each end: reads never get overwritten
+    int l = 8, r = n - 8, wl = 0, wr = n;
+    while (r - l >= 8) {
+        __m256i v;
+        if (l - wl <= wr - r) {
+            v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + l));
+            l += 8;
+        }
+        else {
+            r -= 8;
+            v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + r));
+        }
+
+        // Left lanes to the front, right lanes to the back, then store the whole vector at both ends
+        const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, pivot)));
+        const __m256i order = _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(partitionTable8.order[mask])));
+        const __m256i compacted = _mm256_permutevar8x32_epi32(v, order);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + wl), compacted);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(a + wr - 8), compacted);
+        if (sink) {
+            sink->blockWritten(low + wl, 8, a + wl);
+            sink->blockWritten(low + wr - 8, 8, a + wr - 8);
+        }
+        const int left = partitionTable8.leftCount[mask];
+        wl += left;
+        wr -= 8 - left;
+    }
+
+    const int start = wl, end = wr;
+    int rest[8];
+    const int restCount = r - l;
+    std::copy(a + l, a + r, rest);
+    placeScalar(a, rest, restCount, bound, wl, wr);
+    placeScalar(a, buffered, 16, bound, wl, wr);
+    reportRange(data, low + start, low + end - 1, sink);
+    return low + wl;
+}
+
+SORTING_TARGET_AVX2 void avx2Merge(const int *src, int left, int mid, int right, int *dst, BlockSink *sink)
+{
+    const int *a = src + left;
+    const int *aEnd = src + mid + 1;
+    const int *b = src + mid + 1;
+    const int *bEnd = src + right + 1;
+    int *out = dst + left;
+
+    if (aEnd - a >= 8 && bEnd - b >= 8) {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+        a += 8;
+        b += 8;
+        for (;;) {
+            merge8(low, high);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), low);
+            if (sink) {
+                sink->blockWritten(int(out - dst), 8, out);
+            }
+            out += 8;
+
+            // Everything written so far is <= everything unread; keep the larger half in flight
+            if (aEnd - a < 8 || bEnd - b < 8) {
+                break;
+            }
+            if (*a < *b) {
+                low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+                a += 8;
+            }
+            else {
+                low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+                b += 8;
+            }
+        }
+
+        // Merge the carried vector with the short tail first, then with the long one
+        alignas(32) int carry[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(carry), high);
+        int tail[16];
+        const int *tailEnd;
+        if (aEnd - a < 8) {
+            tailEnd = mergeScalar(carry, carry + 8, a, aEnd, tail);
+            a = b;
+            aEnd = bEnd;
+        }
+        else {
+            tailEnd = mergeScalar(carry, carry + 8, b, bEnd, tail);
+        }
+        mergeScalar(tail, tailEnd, a, aEnd, out);
+        reportRange(dst, int(out - dst), right, sink);
+        return;
+    }
+
+    mergeScalar(a, aEnd, b, bEnd, out);
+    reportRange(dst, left, right, sink);
+}
+
+SORTING_TARGET_AVX2 void avx2SortSmall(int *data, int low, int count, BlockSink *sink)
+{
+    alignas(32) int buffer[SmallSortSize];
+    alignas(32) int temp[SmallSortSize];
+    const int padded = (count + 7) & ~7;
+    std::copy(data + low, data + low + count, buffer);
+    std::fill(buffer + count, buffer + padded, INT_MAX);
+
+    for (int i = 0; i < padded; i += 8) {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(buffer + i));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(buffer + i), sort8(v));
+    }
+
+    int *src = buffer;
+    int *dst = temp;
+    for (int width = 8; width < padded; width *= 2) {
+        for (int left = 0; left < padded; left += 2 * width) {
+            const int mid = std::min(left + width, padded) - 1;
+            const int right = std::min(left + 2 * width, padded) - 1;
+            if (mid < right) {
+                avx2Merge(src, left, mid, right, dst, nullptr);
+            }
+            else {
+                std::copy(src + left, src + right + 1, dst + left);
+            }
+        }
+        std::swap(src, dst);
+    }
+
+    std::copy(src, src + count, data + low);
+    reportRange(data, low, low + count - 1, sink);
+}
+
+const Kernels avx2Kernels = {avx2Partition, avx2SortSmall, avx2Merge};
+
+#endif // SORTING_SIMD_X86
+
+Isa detectIsa()
+{
+#ifdef SORTING_SIMD_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        // AVX2 needs the CPU flag and the OS saving the YMM registers
+        __cpuid(info, 1);
+        const bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        if (osSavesYmm && (info[1] & (1 << 5))) {
+            return Isa::Avx2;
+        }
+    }
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Isa::Avx2;
+    }
+#endif
+    return Isa::Sse2; // Baseline on every x86 CPU Qt 6 runs on
+#else
+    return Isa::Scalar;
+#endif
+}
+
+std::atomic<int> activeIsaOverride{-1};
+
+const Kernels &kernelsFor(Isa isa)
+{
+    switch (isa) {
+#ifdef SORTING_SIMD_X86
+    case Isa::Avx2:
+        return avx2Kernels;
+    case Isa::Sse2:
+        return sse2Kernels;
+#endif
+    default:
+        return scalarKernels;
+    }
+}
+
+int medianOfThree(int a, int b, int c)
+{
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+void quickSortRange(int *data, int low, int high, int depthLimit, const Kernels &kernels, BlockSink *sink)
+{
+    while (high - low + 1 > SmallSortSize) {
+        if (sink && sink->cancelled()) {
+            return;
+        }
+
+        // Too many bad pivots: heap sort the range instead of going quadratic
+        if (depthLimit-- == 0) {
+            std::make_heap(data + low, data + high + 1);
+            std::sort_heap(data + low, data + high + 1);
+            reportRange(data, low, high, sink);
+            return;
+        }
+
+        int pivot;
+        const int mid = low + (high - low) / 2;
+        if (high - low > 1024) {
+            // Ninther: median of the medians of three samples around the ends and the middle
+            const int step = (high - low) / 8;
+            pivot = medianOfThree(medianOfThree(data[low], data[low + step], data[low + 2 * step]),
+                                  medianOfThree(data[mid - step], data[mid], data[mid + step]),
+                                  medianOfThree(data[high - 2 * step], data[high - step], data[high]));
+        }
+        else {
+            pivot = medianOfThree(data[low], data[mid], data[high]);
+        }
+
+        int split = kernels.partition(data, low, high, pivot, sink);
+        if (split > high) {
+            // The pivot is the maximum: split off the elements equal to it instead
+            if (pivot == INT_MIN) {
+                return; // Every element is INT_MIN
+            }
+            split = kernels.partition(data, low, high, pivot - 1, sink);
+            if (split == low) {
+                return; // Every element equals the pivot
+            }
+        }
+
+        // Recurse into the smaller side, loop on the larger one
+        if (split - low < high - split + 1) {
+            quickSortRange(data, low, split - 1, depthLimit, kernels, sink);
+            low = split;
+        }
+        else {
+            quickSortRange(data, split, high, depthLimit, kernels, sink);
+            high = split - 1;
+        }
+    }
+
+    if (high > low) {
+        kernels.sortSmall(data, low, high - low + 1, sink);
+    }
+}
+
+} // namespace
+
+Isa bestIsa()
+{
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+Isa activeIsa()
+{
+    const int requested = activeIsaOverride.load(std::memory_order_relaxed);
+    return requested < 0 ? bestIsa() : Isa(requested);
+}
+
+void setActiveIsa(Isa isa)
+{
+    activeIsaOverride.store(int(std::min(isa, bestIsa())), std::memory_order_relaxed);
+}
+
+const char *isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::Avx2:
+        return "avx2";
+    case Isa::Sse2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+void quickSort(int *data, int n, BlockSink *sink)
+{
+    if (n < 2) {
+        return;
+    }
+
+    int depthLimit = 0;
+    for (int size = n; size > 1; size >>= 1) {
+        depthLimit += 2;
+    }
+    quickSortRange(data, 0, n - 1, depthLimit, kernelsFor(activeIsa()), sink);
+}
+
+void mergeSort(int *data, int n, SortArena &arena, BlockSink *sink)
+{
+    if (n < 2) {
+        return;
+    }
+
+    const Kernels &kernels = kernelsFor(activeIsa());
+
+    // Sorted runs of SmallSortSize from the sorting networks, then vector merges between
+    // data and one scratch array
+    for (int low = 0; low < n; low += SmallSortSize) {
+        if (sink && sink->cancelled()) {
+            return;
+        }
+        kernels.sortSmall(data, low, std::min(SmallSortSize, n - low), sink);
+    }
+
+    SortArena::Scope scope(arena);
+    int *src = data;
+    int *dst = arena.allocate<int>(n);
+    for (int width = SmallSortSize; width < n; width *= 2) {
+        if (sink && sink->cancelled()) {
+            break;
+        }
+        for (int left = 0; left < n; left += 2 * width) {
+            const int mid = std::min(left + width, n) - 1;
+            const int right = std::min(left + 2 * width, n) - 1;
+            if (mid < right) {
+                kernels.merge(src, left, mid, right, dst, sink);
+            }
+            else {
+                std::copy(src + left, src + right + 1, dst + left);
+            }
+        }
+        std::swap(src, dst);
+    }
+
+    // The sink already saw these values written
+    if (src != data) {
+        std::copy(src, src + n, data);
+    }
+}
+
+} // namespace simd
+} // namespace sorting
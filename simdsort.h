@@ -0,0 +1,116 @@
+#ifndef SIMDSORT_H
+#define SIMDSORT_H
+
+#include <type_traits>
+#include "sortkernels.h"
+
+// SIMD sorting kernels for 32-bit ints: AVX2 (8 lanes), SSE2 (4 lanes) or plain scalar code,
+// picked at runtime from what the CPU supports. Both sorts are built from the same three
+// pieces per instruction set:
+//
+//   partition   compare a vector against the pivot, compact it through a lookup table of
+//               lane permutations and store the halves at both ends of the range
+//   sortSmall   bitonic sorting networks inside single registers, then vector merges,
+//               for ranges of up to 64 elements
+//   merge       bitonic merge network over two registers, streaming two sorted runs
+//
+// The kernels only see a BlockSink, told about every block of up to 8 elements they store.
+namespace sorting {
+namespace simd {
+
+enum class Isa { Scalar, Sse2, Avx2 };
+
+// Best instruction set this CPU supports
+Isa bestIsa();
+// Instruction set the kernels use: bestIsa() unless lowered with setActiveIsa()
+Isa activeIsa();
+// Use a lower instruction set, for comparisons. Requests above bestIsa() are clamped.
+void setActiveIsa(Isa isa);
+const char *isaName(Isa isa);
+
+class BlockSink
+{
+public:
+    // count (<= 8) elements were stored at index; values points at them
+    virtual void blockWritten(int index, int count, const int *values) = 0;
+    virtual bool cancelled() const = 0;
+
+protected:
+    ~BlockSink() = default;
+};
+
+void quickSort(int *data, int n, BlockSink *sink);
+void mergeSort(int *data, int n, SortArena &arena, BlockSink *sink);
+
+} // namespace simd
+
+namespace detail {
+
+// Shows every stored block as the range being worked on plus one write per lane
+template <typename Observer>
+class ObserverBlockSink : public simd::BlockSink
+{
+public:
+    explicit ObserverBlockSink(Observer &obs) : m_obs(obs) {}
+
+    void blockWritten(int index, int count, const int *values) override
+    {
+        m_obs.range(index, index + count - 1);
+        for (int i = 0; i < count; ++i) {
+            m_obs.write(index + i, values[i]);
+        }
+        m_obs.pace();
+    }
+
+    bool cancelled() const override { return m_obs.cancelled(); }
+
+private:
+    Observer &m_obs;
+};
+
+} // namespace detail
+
+//////////////////////////
+// Vectorized Quick Sort
+//////////////////////////
+// Other element types use the scalar quick sort
+template <typename T, typename Observer>
+void vectorizedQuickSort(T *data, int n, Observer &obs)
+{
+    if constexpr (std::is_same<T, int>::value) {
+        if constexpr (std::is_same<Observer, NullObserver>::value) {
+            simd::quickSort(data, n, nullptr);
+        }
+        else {
+            detail::ObserverBlockSink<Observer> sink(obs);
+            simd::quickSort(data, n, &sink);
+        }
+    }
+    else {
+        quickSort(data, n, obs);
+    }
+}
+
+//////////////////////////
+// Vectorized Merge Sort
+//////////////////////////
+template <typename T, typename Observer>
+void vectorizedMergeSort(T *data, int n, Observer &obs, SortArena &arena = SortArena::threadLocal())
+{
+    if constexpr (std::is_same<T, int>::value) {
+        if constexpr (std::is_same<Observer, NullObserver>::value) {
+            simd::mergeSort(data, n, arena, nullptr);
+        }
+        else {
+            detail::ObserverBlockSink<Observer> sink(obs);
+            simd::mergeSort(data, n, arena, &sink);
+        }
+    }
+    else {
+        mergeSort(data, n, obs, arena);
+    }
+}
+
+} // namespace sorting
+
+#endif // SIMDSORT_H
@@ -0,0 +1,261 @@
+#ifndef SORTALGORITHMS_H
+#define SORTALGORITHMS_H
+
+#include <QString>
+#include <QStringList>
+#include <iterator>
+#include "sortkernels.h"
+#include "parallelsort.h"
+#include "simdsort.h"
+
+// Registry of every algorithm the GUI and the benchmark can run.
+// Adding an algorithm means one enum value, one table row and one case in runSortAlgorithm;
+// the combo box, the Worker and the benchmark all pick it up from here.
+enum class SortAlgorithm : int {
+    Bubble,
+    Selection,
+    Insertion,
+    Merge,
+    BottomUpMerge,
+    PingPongMerge,
+    Quick,
+    QuickThreeWay,
+    Heap,
+    // Heap Sort variants, contiguous for "Compare heaps"
+    Heap4,
+    Heap8,
+    HeapBottomUp,
+    HeapPrefetch,
+    Counting,
+    Shell,
+    // Shell Sort with the other gap sequences, contiguous and in GapSequence order
+    ShellHibbard,
+    ShellKnuth,
+    ShellSedgewick,
+    ShellPratt,
+    ShellCiura,
+    ShellTokuda,
+    Radix,
+    Radix11,
+    Radix16,
+    Bucket,
+    Intro,
+    Pdq,
+    PdqBranchless,
+    ParallelMerge,
+    ParallelQuick,
+    ParallelRadix,
+    ParallelCounting,
+    VectorizedQuick,
+    VectorizedMerge,
+    Count
+};
+
+struct SortAlgorithmInfo
+{
+    SortAlgorithm id;
+    const char *name;       // Shown in the combo box, chart titles and benchmark output
+    const char *complexity; // Average case
+    int stepCost;           // Pacing budget one visible step uses, so slow-looking steps get more time
+    bool stable;
+    bool inPlace;
+    bool parallel;          // Splits its work across a WorkStealingPool
+};
+
+// In combo box order, indexed by SortAlgorithm
+inline constexpr SortAlgorithmInfo sortAlgorithmTable[] = {
+    // id                            name                     complexity    cost  stable inPlace parallel
+    {SortAlgorithm::Bubble,          "Bubble Sort",           "O(n^2)",     3,    true,  true,   false},
+    {SortAlgorithm::Selection,       "Selection Sort",        "O(n^2)",     4,    false, true,   false},
+    {SortAlgorithm::Insertion,       "Insertion Sort",        "O(n^2)",     4,    true,  true,   false},
+    {SortAlgorithm::Merge,           "Merge Sort",            "O(n log n)", 2,    true,  false,  false},
+    {SortAlgorithm::BottomUpMerge,   "Bottom-Up Merge Sort",  "O(n log n)", 2,    true,  false,  false},
+    {SortAlgorithm::PingPongMerge,   "Ping-Pong Merge Sort",  "O(n log n)", 2,    true,  false,  false},
+    {SortAlgorithm::Quick,           "Quick Sort",            "O(n log n)", 2,    false, true,   false},
+    {SortAlgorithm::QuickThreeWay,   "Quick Sort (3-Way)",    "O(n log n)", 2,    false, true,   false},
+    {SortAlgorithm::Heap,            "Heap Sort",             "O(n log n)", 2,    false, true,   false},
+    {SortAlgorithm::Heap4,           "Heap Sort (4-ary)",     "O(n log n)", 2,    false, false,  false},
+    {SortAlgorithm::Heap8,           "Heap Sort (8-ary)",     "O(n log n)", 2,    false, false,  false},
+    {SortAlgorithm::HeapBottomUp,    "Heap Sort (Bottom-Up)", "O(n log n)", 2,    false, true,   false},
+    {SortAlgorithm::HeapPrefetch,    "Heap Sort (Prefetch)",  "O(n log n)", 2,    false, false,  false},
+    {SortAlgorithm::Counting,        "Counting Sort",         "O(n + k)",   1,    true,  false,  false},
+    {SortAlgorithm::Shell,           "Shell Sort",            "O(n^1.5)",   3,    false, true,   false},
+    {SortAlgorithm::ShellHibbard,    "Shell Sort (Hibbard)",  "O(n^1.25)",  3,    false, true,   false},
+    {SortAlgorithm::ShellKnuth,      "Shell Sort (Knuth)",    "O(n^1.25)",  3,    false, true,   false},
+    {SortAlgorithm::ShellSedgewick,  "Shell Sort (Sedgewick)", "O(n^7/6)",  3,    false, true,   false},
+    {SortAlgorithm::ShellPratt,      "Shell Sort (Pratt)",    "O(n log^2 n)", 3,  false, true,   false},
+    {SortAlgorithm::ShellCiura,      "Shell Sort (Ciura)",    "O(n^1.2)",   3,    false, true,   false},
+    {SortAlgorithm::ShellTokuda,     "Shell Sort (Tokuda)",   "O(n^1.2)",   3,    false, true,   false},
+    {SortAlgorithm::Radix,           "Radix Sort",            "O(d n)",     1,    true,  false,  false},
+    {SortAlgorithm::Radix11,         "Radix Sort (11-bit)",   "O(d n)",     1,    true,  false,  false},
+    {SortAlgorithm::Radix16,         "Radix Sort (16-bit)",   "O(d n)",     1,    true,  false,  false},
+    {SortAlgorithm::Bucket,          "Bucket Sort",           "O(n + k)",   1,    false, false,  false},
+    {SortAlgorithm::Intro,           "Intro Sort",            "O(n log n)", 2,    false, true,   false},
+    {SortAlgorithm::Pdq,             "PDQ Sort",              "O(n log n)", 2,    false, true,   false},
+    {SortAlgorithm::PdqBranchless,   "PDQ Sort (Branchless)", "O(n log n)", 2,    false, true,   false},
+    {SortAlgorithm::ParallelMerge,   "Parallel Merge Sort",   "O(n log n)", 2,    true,  false,  true},
+    {SortAlgorithm::ParallelQuick,   "Parallel Quick Sort",   "O(n log n)", 2,    false, true,   true},
+    {SortAlgorithm::ParallelRadix,   "Parallel Radix Sort",   "O(d n)",     1,    true,  false,  true},
+    {SortAlgorithm::ParallelCounting, "Parallel Counting Sort", "O(n + k)", 1,   true,  false,  true},
+    {SortAlgorithm::VectorizedQuick, "Vectorized Quick Sort", "O(n log n)", 2,    false, true,   false},
+    {SortAlgorithm::VectorizedMerge, "Vectorized Merge Sort", "O(n log n)", 2,    false, false,  false},
+};
+
+constexpr bool sortAlgorithmTableIsOrdered()
+{
+    for (int i = 0; i < int(std::size(sortAlgorithmTable)); ++i) {
+        if (int(sortAlgorithmTable[i].id) != i) {
+            return false;
+        }
+    }
+    return int(std::size(sortAlgorithmTable)) == int(SortAlgorithm::Count);
+}
+static_assert(sortAlgorithmTableIsOrdered(), "sortAlgorithmTable must list every SortAlgorithm in enum order");
+static_assert(int(SortAlgorithm::ShellTokuda) - int(SortAlgorithm::Shell) == int(sorting::GapSequence::Tokuda),
+              "Shell Sort variants must follow GapSequence order");
+
+constexpr int sortAlgorithmCount()
+{
+    return int(SortAlgorithm::Count);
+}
+
+constexpr const SortAlgorithmInfo &sortAlgorithmInfo(SortAlgorithm id)
+{
+    return sortAlgorithmTable[int(id)];
+}
+
+// Index of the algorithm with this name, -1 when there is none
+inline int findSortAlgorithm(const QString &name)
+{
+    for (int i = 0; i < sortAlgorithmCount(); ++i) {
+        if (name == QLatin1String(sortAlgorithmTable[i].name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+inline QStringList sortAlgorithmNames()
+{
+    QStringList names;
+    for (const SortAlgorithmInfo &info : sortAlgorithmTable) {
+        names << QString::fromLatin1(info.name);
+    }
+    return names;
+}
+
+// Run an algorithm on data with the given observer, returns false for an invalid id.
+// Parallel algorithms use pool, or the global pool when none is given.
+template <typename T, typename Observer>
+bool runSortAlgorithm(SortAlgorithm id, T *data, int n, Observer &obs, WorkStealingPool *pool = nullptr)
+{
+    switch (id) {
+    case SortAlgorithm::Bubble:
+        sorting::bubbleSort(data, n, obs);
+        break;
+    case SortAlgorithm::Selection:
+        sorting::selectionSort(data, n, obs);
+        break;
+    case SortAlgorithm::Insertion:
+        sorting::insertionSort(data, n, obs);
+        break;
+    case SortAlgorithm::Merge:
+        sorting::mergeSort(data, n, obs);
+        break;
+    case SortAlgorithm::BottomUpMerge:
+        sorting::bottomUpMergeSort(data, n, obs);
+        break;
+    case SortAlgorithm::PingPongMerge:
+        sorting::pingPongMergeSort(data, n, obs);
+        break;
+    case SortAlgorithm::Quick:
+        sorting::quickSort(data, n, obs);
+        break;
+    case SortAlgorithm::QuickThreeWay:
+        sorting::quickSortThreeWay(data, n, obs);
+        break;
+    case SortAlgorithm::Heap:
+        sorting::heapSort(data, n, obs);
+        break;
+    case SortAlgorithm::Heap4:
+        sorting::dAryHeapSort<4>(data, n, obs);
+        break;
+    case SortAlgorithm::Heap8:
+        sorting::dAryHeapSort<8>(data, n, obs);
+        break;
+    case SortAlgorithm::HeapBottomUp:
+        sorting::bottomUpHeapSort(data, n, obs);
+        break;
+    case SortAlgorithm::HeapPrefetch:
+        sorting::prefetchHeapSort(data, n, obs);
+        break;
+    case SortAlgorithm::Counting:
+        sorting::countingSort(data, n, obs);
+        break;
+    case SortAlgorithm::Shell:
+        sorting::shellSort(data, n, obs); // Shell's own halving gaps
+        break;
+    case SortAlgorithm::ShellHibbard:
+        sorting::shellSort(data, n, obs, sorting::GapSequence::Hibbard);
+        break;
+    case SortAlgorithm::ShellKnuth:
+        sorting::shellSort(data, n, obs, sorting::GapSequence::Knuth);
+        break;
+    case SortAlgorithm::ShellSedgewick:
+        sorting::shellSort(data, n, obs, sorting::GapSequence::Sedgewick);
+        break;
+    case SortAlgorithm::ShellPratt:
+        sorting::shellSort(data, n, obs, sorting::GapSequence::Pratt);
+        break;
+    case SortAlgorithm::ShellCiura:
+        sorting::shellSort(data, n, obs, sorting::GapSequence::Ciura);
+        break;
+    case SortAlgorithm::ShellTokuda:
+        sorting::shellSort(data, n, obs, sorting::GapSequence::Tokuda);
+        break;
+    case SortAlgorithm::Radix:
+        sorting::radixSort(data, n, obs); // 8-bit digits
+        break;
+    case SortAlgorithm::Radix11:
+        sorting::lsdRadixSort<11>(data, n, obs);
+        break;
+    case SortAlgorithm::Radix16:
+        sorting::lsdRadixSort<16>(data, n, obs);
+        break;
+    case SortAlgorithm::Bucket:
+        sorting::bucketSort(data, n, obs);
+        break;
+    case SortAlgorithm::Intro:
+        sorting::introSort(data, n, obs);
+        break;
+    case SortAlgorithm::Pdq:
+        sorting::pdqSort<false>(data, n, obs);
+        break;
+    case SortAlgorithm::PdqBranchless:
+        sorting::pdqSort<true>(data, n, obs);
+        break;
+    case SortAlgorithm::ParallelMerge:
+        sorting::parallelMergeSort(data, n, obs, pool ? *pool : WorkStealingPool::global());
+        break;
+    case SortAlgorithm::ParallelQuick:
+        sorting::parallelQuickSort(data, n, obs, pool ? *pool : WorkStealingPool::global());
+        break;
+    case SortAlgorithm::ParallelRadix:
+        sorting::parallelRadixSort<8>(data, n, obs, pool ? *pool : WorkStealingPool::global());
+        break;
+    case SortAlgorithm::ParallelCounting:
+        sorting::parallelCountingSort(data, n, obs, pool ? *pool : WorkStealingPool::global());
+        break;
+    case SortAlgorithm::VectorizedQuick:
+        sorting::vectorizedQuickSort(data, n, obs);
+        break;
+    case SortAlgorithm::VectorizedMerge:
+        sorting::vectorizedMergeSort(data, n, obs);
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+#endif // SORTALGORITHMS_H
@@ -0,0 +1,166 @@
+#ifndef SORTARENA_H
+#define SORTARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace sorting {
+
+// Scratch memory for the kernels that need auxiliary arrays (merge buffers, counting
+// histograms, radix output). Allocation is a pointer bump; memory is handed back when the
+// enclosing Scope ends. Once a run has needed more than one block the blocks are merged, so
+// from then on the same run size is served from a single block without touching the heap.
+class SortArena
+{
+public:
+    SortArena() = default;
+    SortArena(const SortArena &) = delete;
+    SortArena &operator=(const SortArena &) = delete;
+
+    // Arena owned by the calling thread, reused by every run on that thread
+    static SortArena &threadLocal()
+    {
+        thread_local SortArena arena;
+        return arena;
+    }
+
+    // Marks the arena on construction and releases everything allocated since on destruction
+    class Scope
+    {
+    public:
+        explicit Scope(SortArena &arena)
+            : m_arena(arena), m_block(arena.m_current), m_offset(arena.m_offset)
+        {
+            m_arena.m_depth++;
+        }
+
+        ~Scope()
+        {
+            m_arena.m_current = m_block;
+            m_arena.m_offset = m_offset;
+            if (--m_arena.m_depth == 0) {
+                m_arena.consolidate();
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        SortArena &m_arena;
+        std::size_t m_block;
+        std::size_t m_offset;
+    };
+
+    // Uninitialized, cache-line aligned room for count elements
+    template <typename T>
+    T *allocate(std::size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "arena memory is never constructed");
+        static_assert(alignof(T) <= Alignment, "type needs more than cache-line alignment");
+
+        const std::size_t bytes = roundUp(std::max<std::size_t>(count * sizeof(T), 1));
+        for (; m_current < m_blocks.size(); ++m_current, m_offset = 0) {
+            Block &block = m_blocks[m_current];
+            if (block.size - m_offset >= bytes) {
+                T *result = reinterpret_cast<T *>(block.memory.get() + m_offset);
+                m_offset += bytes;
+                notePeak();
+                return result;
+            }
+        }
+
+        m_blocks.emplace_back(std::max(bytes, MinBlockSize));
+        m_current = m_blocks.size() - 1;
+        m_offset = bytes;
+        notePeak();
+        return reinterpret_cast<T *>(m_blocks.back().memory.get());
+    }
+
+    // Bytes handed out and not yet released by a Scope, including alignment padding
+    std::size_t usage() const
+    {
+        std::size_t total = m_offset;
+        for (std::size_t i = 0; i < m_current && i < m_blocks.size(); ++i) {
+            total += m_blocks[i].size;
+        }
+        return total;
+    }
+
+    // Highest usage() since the last resetPeak(), the auxiliary memory of a run
+    std::size_t peakUsage() const { return m_peak; }
+    void resetPeak() { m_peak = usage(); }
+
+    // Bytes currently held, used or not
+    std::size_t capacity() const
+    {
+        std::size_t total = 0;
+        for (const Block &block : m_blocks) {
+            total += block.size;
+        }
+        return total;
+    }
+
+    // Give all memory back to the system (only outside of any Scope)
+    void release()
+    {
+        if (m_depth == 0) {
+            m_blocks.clear();
+            m_current = 0;
+            m_offset = 0;
+        }
+    }
+
+private:
+    static constexpr std::size_t Alignment = 64;
+    static constexpr std::size_t MinBlockSize = 64 * 1024;
+
+    struct AlignedDelete
+    {
+        void operator()(unsigned char *memory) const { ::operator delete(memory, std::align_val_t(Alignment)); }
+    };
+
+    struct Block
+    {
+        explicit Block(std::size_t size)
+            : memory(static_cast<unsigned char *>(::operator new(size, std::align_val_t(Alignment)))), size(size)
+        {
+        }
+
+        std::unique_ptr<unsigned char[], AlignedDelete> memory;
+        std::size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    std::size_t m_current = 0; // Block the next allocation is tried in
+    std::size_t m_offset = 0;  // First free byte in that block
+    int m_depth = 0;           // Open scopes
+    std::size_t m_peak = 0;
+
+    void notePeak() { m_peak = std::max(m_peak, usage()); }
+
+    static std::size_t roundUp(std::size_t bytes)
+    {
+        return (bytes + Alignment - 1) / Alignment * Alignment;
+    }
+
+    // Replace several blocks by one as large as all of them together
+    void consolidate()
+    {
+        if (m_blocks.size() > 1) {
+            const std::size_t total = capacity();
+            m_blocks.clear();
+            m_blocks.emplace_back(total);
+        }
+        m_current = 0;
+        m_offset = 0;
+    }
+};
+
+} // namespace sorting
+
+#endif // SORTARENA_H
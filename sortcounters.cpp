@@ -0,0 +1,34 @@
+#include "sortcounters.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace sorting {
+
+long long threadCpuTimeNs()
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    // 100 ns units
+    const auto toNs = [](const FILETIME &time) {
+        return ((long long)time.dwHighDateTime << 32 | time.dwLowDateTime) * 100;
+    };
+    return toNs(kernel) + toNs(user);
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+        return 0;
+    }
+    return (long long)time.tv_sec * 1000000000 + time.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+} // namespace sorting
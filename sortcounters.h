@@ -0,0 +1,50 @@
+#ifndef SORTCOUNTERS_H
+#define SORTCOUNTERS_H
+
+#include <atomic>
+#include "sortkernels.h"
+
+namespace sorting {
+
+// Live instrumentation of one run. The run counts into a plain CountingObserver and publishes
+// it here at step batch and pacing boundaries; the GUI reads whenever it redraws. Every access
+// is relaxed: each counter has a single writer and readers only need a recent value, not a
+// snapshot that is consistent across counters.
+struct SortCounters
+{
+    std::atomic<long long> comparisons{0};
+    std::atomic<long long> swaps{0};
+    std::atomic<long long> writes{0};
+    std::atomic<long long> cacheMisses{0}; // Estimated, see detail::CacheModel
+    std::atomic<long long> dataBytes{0};   // The elements being sorted
+    std::atomic<long long> auxBytes{0};    // Peak scratch memory taken from the run's arena
+    std::atomic<long long> cpuNs{0};       // CPU time of the run's thread, waiting costs none
+
+    // Monotonic wall-clock time since the run started (its length once finished), split into
+    // waiting for the step budget or for resume, handing step batches to the GUI, and the rest,
+    // which is the algorithm itself
+    std::atomic<long long> wallNs{0};
+    std::atomic<long long> waitNs{0};
+    std::atomic<long long> emitNs{0};
+
+    long long algorithmNs() const
+    {
+        return wallNs.load(std::memory_order_relaxed) - waitNs.load(std::memory_order_relaxed)
+               - emitNs.load(std::memory_order_relaxed);
+    }
+
+    void publish(const CountingObserver &counts)
+    {
+        comparisons.store(counts.comparisons, std::memory_order_relaxed);
+        swaps.store(counts.swaps, std::memory_order_relaxed);
+        writes.store(counts.writes, std::memory_order_relaxed);
+        cacheMisses.store(counts.cacheMisses, std::memory_order_relaxed);
+    }
+};
+
+// CPU time the calling thread has used so far, in nanoseconds (0 where unsupported)
+long long threadCpuTimeNs();
+
+} // namespace sorting
+
+#endif // SORTCOUNTERS_H
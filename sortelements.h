@@ -0,0 +1,187 @@
+#ifndef SORTELEMENTS_H
+#define SORTELEMENTS_H
+
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include "sortkernels.h"
+
+// Element types the sorting engine runs on besides int. The GUI and the benchmark generate
+// int inputs; every type is built from those values (makeElement) and shown as bar heights
+// again (barHeight), so the charts and traces stay int arrays whatever was sorted.
+namespace sorting {
+
+// Ordered by key alone; the payload is dragged along by every move, which is the cost records
+// add over bare keys. payload[0] holds the element's input position.
+template <int PayloadWords>
+struct KeyedRecord
+{
+    long long key;
+    long long payload[PayloadWords];
+
+    friend bool operator<(const KeyedRecord &a, const KeyedRecord &b) { return a.key < b.key; }
+    friend bool operator>(const KeyedRecord &a, const KeyedRecord &b) { return a.key > b.key; }
+    friend bool operator<=(const KeyedRecord &a, const KeyedRecord &b) { return a.key <= b.key; }
+    friend bool operator>=(const KeyedRecord &a, const KeyedRecord &b) { return a.key >= b.key; }
+    friend bool operator==(const KeyedRecord &a, const KeyedRecord &b) { return a.key == b.key; }
+    friend bool operator!=(const KeyedRecord &a, const KeyedRecord &b) { return a.key != b.key; }
+};
+
+using Record = KeyedRecord<1>;     // 16 bytes: 64-bit key, 64-bit payload
+using WideRecord = KeyedRecord<7>; // 64 bytes, one cache line per element
+
+template <int PayloadWords>
+struct SortKey<KeyedRecord<PayloadWords>>
+{
+    using Type = long long;
+    static const long long &get(const KeyedRecord<PayloadWords> &record) { return record.key; }
+};
+
+template <int PayloadWords>
+struct RadixKey<KeyedRecord<PayloadWords>>
+{
+    using Type = RadixKey<long long>::Type;
+    static Type toKey(const KeyedRecord<PayloadWords> &record) { return RadixKey<long long>::toKey(record.key); }
+};
+
+enum class ElementType : int {
+    Int32,
+    Int64,
+    Float,
+    Double,
+    Record,
+    WideRecord,
+    Count
+};
+
+struct ElementTypeInfo
+{
+    ElementType id;
+    const char *name; // Combo box and the benchmark's --types
+    int bytes;
+};
+
+// Indexed by ElementType
+inline constexpr ElementTypeInfo elementTypeTable[] = {
+    {ElementType::Int32,      "int32",    int(sizeof(int))},
+    {ElementType::Int64,      "int64",    int(sizeof(long long))},
+    {ElementType::Float,      "float",    int(sizeof(float))},
+    {ElementType::Double,     "double",   int(sizeof(double))},
+    {ElementType::Record,     "record",   int(sizeof(Record))},
+    {ElementType::WideRecord, "record64", int(sizeof(WideRecord))},
+};
+static_assert(int(std::size(elementTypeTable)) == int(ElementType::Count), "elementTypeTable must list every ElementType");
+
+constexpr const ElementTypeInfo &elementTypeInfo(ElementType id)
+{
+    return elementTypeTable[int(id)];
+}
+
+// Index of the type with this name, -1 when there is none
+inline int findElementType(const char *name)
+{
+    for (int i = 0; i < int(ElementType::Count); ++i) {
+        if (std::strcmp(name, elementTypeTable[i].name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// makeElement(value, index) builds the element for input value at index; barHeight() maps it
+// back to the value for drawing, exactly for every type but float above 2^24.
+template <typename T>
+struct ElementTraits;
+
+template <>
+struct ElementTraits<int>
+{
+    static int makeElement(int value, int) { return value; }
+    static int barHeight(int element) { return element; }
+};
+
+// The value in the high half orders the keys; the low half is a hash of the index, so that
+// keys are distinct and every radix pass has work to do, as with real 64-bit keys
+template <>
+struct ElementTraits<long long>
+{
+    static long long makeElement(int value, int index)
+    {
+        unsigned low = unsigned(index) * 2654435761u;
+        low ^= low >> 16;
+        return (long long)((unsigned long long)(long long)value << 32 | low);
+    }
+    static int barHeight(long long element) { return int(element >> 32); }
+};
+
+template <>
+struct ElementTraits<float>
+{
+    static float makeElement(int value, int) { return float(value); }
+    static int barHeight(float element) { return int(std::lround(element)); }
+};
+
+template <>
+struct ElementTraits<double>
+{
+    static double makeElement(int value, int) { return double(value); }
+    static int barHeight(double element) { return int(element); }
+};
+
+template <int PayloadWords>
+struct ElementTraits<KeyedRecord<PayloadWords>>
+{
+    static KeyedRecord<PayloadWords> makeElement(int value, int index)
+    {
+        KeyedRecord<PayloadWords> record;
+        record.key = ElementTraits<long long>::makeElement(value, index);
+        std::fill(record.payload, record.payload + PayloadWords, (long long)index);
+        return record;
+    }
+    static int barHeight(const KeyedRecord<PayloadWords> &element) { return ElementTraits<long long>::barHeight(element.key); }
+};
+
+template <typename T>
+int barHeight(const T &element)
+{
+    return ElementTraits<T>::barHeight(element);
+}
+
+template <typename T>
+struct ElementTag
+{
+    using Type = T;
+};
+
+// Calls function(ElementTag<T>()) with the C++ type of type, returns false for an invalid type
+template <typename Function>
+bool visitElementType(ElementType type, Function &&function)
+{
+    switch (type) {
+    case ElementType::Int32:
+        function(ElementTag<int>());
+        break;
+    case ElementType::Int64:
+        function(ElementTag<long long>());
+        break;
+    case ElementType::Float:
+        function(ElementTag<float>());
+        break;
+    case ElementType::Double:
+        function(ElementTag<double>());
+        break;
+    case ElementType::Record:
+        function(ElementTag<Record>());
+        break;
+    case ElementType::WideRecord:
+        function(ElementTag<WideRecord>());
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+} // namespace sorting
+
+#endif // SORTELEMENTS_H
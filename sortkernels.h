@@ -0,0 +1,1637 @@
+#ifndef SORTKERNELS_H
+#define SORTKERNELS_H
+
+#include <algorithm>
+#include <cmath> // For log function
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "sortarena.h"
+
+// Header-only sorting algorithms, free of Qt and of any visualization code.
+//
+// Every algorithm takes an observer that is told about each comparison, swap and write,
+// and gets a chance to pace or cancel the run:
+//
+//   obs.compare(i, j)     elements at i and j were compared
+//   obs.swap(i, j)        elements at i and j were swapped
+//   obs.write(i, value)   value was stored at i
+//   obs.range(low, high)  the algorithm starts working on [low, high]
+//   obs.owner(low, high, thread)  pool thread `thread` handles [low, high] (parallel sorts)
+//   obs.pace()            a visible step is complete (the GUI waits for its step budget here)
+//   obs.cancelled()       true when the run should stop. The quadratic sorts only ask once
+//                         per outer iteration, keeping their compare loops free of it.
+//
+// With NullObserver all of these are empty inline functions and the compiler is left with
+// the bare algorithm. Kernels that need auxiliary arrays take them from a SortArena, by
+// default the calling thread's, so repeated runs do not allocate.
+namespace sorting {
+
+struct NullObserver
+{
+    void compare(int, int) {}
+    void swap(int, int) {}
+    template <typename T>
+    void write(int, const T &) {}
+    void range(int, int) {}
+    void owner(int, int, int) {}
+    void pace() {}
+    bool cancelled() const { return false; }
+};
+
+namespace detail {
+
+// Direct-mapped model of a 32 KB data cache with 64-byte lines, fed with the indices a kernel
+// reports. Scratch arrays and the stack are invisible to it, so the miss count is an estimate
+// for the array itself: good for comparing access patterns, not for predicting hardware.
+class CacheModel
+{
+public:
+    static constexpr int LineBytes = 64;
+    static constexpr int LineCount = 512;
+
+    explicit CacheModel(int elementBytes = sizeof(int)) : m_elementBytes(elementBytes)
+    {
+        std::fill(m_tags, m_tags + LineCount, -1);
+    }
+
+    // True when the element at index was not in the cache
+    bool touch(int index)
+    {
+        const long long line = (long long)index * m_elementBytes / LineBytes;
+        long long &tag = m_tags[line % LineCount];
+        if (tag == line) {
+            return false;
+        }
+        tag = line;
+        return true;
+    }
+
+private:
+    int m_elementBytes;
+    long long m_tags[LineCount];
+};
+
+} // namespace detail
+
+// Counts operations, used by the headless benchmark and the GUI's live counters
+struct CountingObserver
+{
+    long long comparisons = 0;
+    long long swaps = 0;
+    long long writes = 0;
+    long long cacheMisses = 0; // Estimated, see detail::CacheModel
+
+    // Size of the elements sorted, so the cache model sees how many share a line
+    explicit CountingObserver(int elementBytes = sizeof(int)) : m_cache(elementBytes) {}
+
+    void compare(int i, int j) { comparisons++; access(i); access(j); }
+    void swap(int i, int j) { swaps++; access(i); access(j); }
+    template <typename T>
+    void write(int i, const T &) { writes++; access(i); }
+    void range(int, int) {}
+    void owner(int, int, int) {}
+    void pace() {}
+    bool cancelled() const { return false; }
+
+private:
+    detail::CacheModel m_cache;
+
+    void access(int index) { cacheMisses += m_cache.touch(index); }
+};
+
+// Key an element is ordered by: the element itself, or the key field of a record type
+// (see sortelements.h). Only the kernels that compute with keys need it.
+template <typename T, typename Enable = void>
+struct SortKey
+{
+    using Type = T;
+    static const T &get(const T &value) { return value; }
+};
+
+namespace detail {
+
+// Merge the sorted runs [left, mid] and [mid + 1, right] in place. Only the left run is
+// copied out, to scratch[left..mid]; the merge never overtakes the right run's read position.
+template <typename T, typename Observer>
+void mergeRuns(T *data, T *scratch, int left, int mid, int right, Observer &obs)
+{
+    std::copy(data + left, data + mid + 1, scratch + left);
+
+    int i = left, j = mid + 1, k = left;
+
+    obs.range(left, right);
+
+    while (i <= mid && j <= right && !obs.cancelled()) {
+        obs.compare(i, j);
+        if (scratch[i] <= data[j]) {
+            data[k] = scratch[i++];
+        }
+        else {
+            data[k] = data[j++];
+        }
+        obs.write(k, data[k]);
+        k++;
+
+        obs.pace();
+    }
+
+    // Always put the rest of the left run back, so a cancelled run still holds every element.
+    // What is left of the right run is already in place.
+    while (i <= mid) {
+        obs.write(k, scratch[i]);
+        data[k++] = scratch[i++];
+    }
+}
+
+// Merge src[left..mid] and src[mid + 1..right] into dst[left..right]
+template <typename T, typename Observer>
+void mergeInto(const T *src, T *dst, int left, int mid, int right, Observer &obs)
+{
+    int i = left, j = mid + 1, k = left;
+
+    obs.range(left, right);
+
+    while (i <= mid && j <= right && !obs.cancelled()) {
+        obs.compare(i, j);
+        if (src[i] <= src[j]) {
+            dst[k] = src[i++];
+        }
+        else {
+            dst[k] = src[j++];
+        }
+        obs.write(k, dst[k]);
+        k++;
+
+        obs.pace();
+    }
+
+    while (i <= mid) {
+        obs.write(k, src[i]);
+        dst[k++] = src[i++];
+    }
+    while (j <= right) {
+        obs.write(k, src[j]);
+        dst[k++] = src[j++];
+    }
+}
+
+// scratch is indexed like data, so disjoint ranges can be sorted concurrently
+template <typename T, typename Observer>
+void mergeSortRecursive(T *data, T *scratch, int left, int right, Observer &obs)
+{
+    if (left >= right || obs.cancelled()) {
+        return;
+    }
+
+    int mid = left + (right - left) / 2;
+    mergeSortRecursive(data, scratch, left, mid, obs);
+    mergeSortRecursive(data, scratch, mid + 1, right, obs);
+
+    mergeRuns(data, scratch, left, mid, right, obs);
+}
+
+// Lomuto partition around the last element
+template <typename T, typename Observer>
+int partition(T *data, int low, int high, Observer &obs)
+{
+    T pivot = data[high];
+    int i = low - 1;
+
+    obs.range(low, high);
+
+    for (int j = low; j <= high - 1 && !obs.cancelled(); j++) {
+        obs.compare(j, high);
+        if (data[j] < pivot) {
+            i++;
+            std::swap(data[i], data[j]);
+            obs.swap(i, j);
+        }
+    }
+    std::swap(data[i + 1], data[high]);
+    obs.swap(i + 1, high);
+    return (i + 1);
+}
+
+inline int log2Floor(int n)
+{
+    int log = 0;
+    while (n > 1) {
+        n >>= 1;
+        log++;
+    }
+    return log;
+}
+
+template <typename T, typename Observer>
+void swapElements(T *data, int a, int b, Observer &obs)
+{
+    std::swap(data[a], data[b]);
+    obs.swap(a, b);
+}
+
+template <typename T, typename Observer>
+void compareSwap(T *data, int a, int b, Observer &obs)
+{
+    obs.compare(a, b);
+    if (data[b] < data[a]) {
+        swapElements(data, a, b, obs);
+    }
+}
+
+// Leaves data[a] <= data[b] <= data[c]
+template <typename T, typename Observer>
+void sortThree(T *data, int a, int b, int c, Observer &obs)
+{
+    compareSwap(data, a, b, obs);
+    compareSwap(data, b, c, obs);
+    compareSwap(data, a, b, obs);
+}
+
+// Iterative: the larger side waits on an explicit stack while the smaller one is sorted, so at
+// most log2(n) ranges are ever pending, even when every pivot is the largest element
+template <typename T, typename Observer>
+void quickSortIterative(T *data, int low, int high, Observer &obs)
+{
+    struct Range
+    {
+        int low;
+        int high;
+    };
+    Range pending[64];
+    int pendingCount = 0;
+
+    for (;;) {
+        while (low < high && !obs.cancelled()) {
+            int pi = partition(data, low, high, obs);
+
+            obs.pace();
+
+            if (pi - low < high - pi) {
+                pending[pendingCount++] = {pi + 1, high};
+                high = pi - 1;
+            }
+            else {
+                pending[pendingCount++] = {low, pi - 1};
+                low = pi + 1;
+            }
+        }
+        if (pendingCount == 0 || obs.cancelled()) {
+            return;
+        }
+        pendingCount--;
+        low = pending[pendingCount].low;
+        high = pending[pendingCount].high;
+    }
+}
+
+// Dutch national flag partition around data[low]: afterwards [low, lt) < pivot, [lt, gt] equal
+// to it and (gt, high] > pivot, so a run of equal keys is finished in a single pass
+template <typename T, typename Observer>
+void partitionThreeWay(T *data, int low, int high, int &lt, int &gt, Observer &obs)
+{
+    const T pivot = data[low];
+    lt = low;
+    gt = high;
+    int i = low + 1;
+
+    obs.range(low, high);
+
+    // data[lt] always holds a copy of the pivot
+    while (i <= gt && !obs.cancelled()) {
+        obs.compare(i, lt);
+        if (data[i] < pivot) {
+            swapElements(data, lt++, i++, obs);
+            obs.pace();
+        }
+        else if (pivot < data[i]) {
+            swapElements(data, i, gt--, obs);
+            obs.pace();
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+// Same explicit stack as quickSortIterative, the pivot's whole run of equal keys is left out
+template <typename T, typename Observer>
+void quickSortThreeWayIterative(T *data, int low, int high, Observer &obs)
+{
+    struct Range
+    {
+        int low;
+        int high;
+    };
+    Range pending[64];
+    int pendingCount = 0;
+
+    for (;;) {
+        while (low < high && !obs.cancelled()) {
+            // Median of the quartiles and the middle, moved to data[low]. First, middle and last
+            // would pick a near-minimum on the rotated runs this partition leaves on sorted input.
+            const int quarter = (high - low + 1) / 4;
+            const int mid = low + (high - low) / 2;
+            sortThree(data, low + quarter, mid, high - quarter, obs);
+            swapElements(data, low, mid, obs);
+            int lt;
+            int gt;
+            partitionThreeWay(data, low, high, lt, gt, obs);
+
+            if (lt - low < high - gt) {
+                pending[pendingCount++] = {gt + 1, high};
+                high = lt - 1;
+            }
+            else {
+                pending[pendingCount++] = {low, lt - 1};
+                low = gt + 1;
+            }
+        }
+        if (pendingCount == 0 || obs.cancelled()) {
+            return;
+        }
+        pendingCount--;
+        low = pending[pendingCount].low;
+        high = pending[pendingCount].high;
+    }
+}
+
+// Iterative sift-down of heap index i in the size-element heap stored at data[low..]
+template <typename T, typename Observer>
+void siftDown(T *data, int low, int size, int i, Observer &obs)
+{
+    T value = data[low + i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size) {
+            obs.compare(low + child, low + child + 1);
+            if (data[low + child] < data[low + child + 1]) {
+                child++;
+            }
+        }
+        obs.compare(low + i, low + child);
+        if (!(value < data[low + child])) {
+            break;
+        }
+        data[low + i] = data[low + child];
+        obs.write(low + i, data[low + i]);
+        i = child;
+    }
+    data[low + i] = value;
+    obs.write(low + i, value);
+}
+
+// Heap sort of [low, high] alone
+template <typename T, typename Observer>
+void heapSortRange(T *data, int low, int high, Observer &obs)
+{
+    const int size = high - low + 1;
+    obs.range(low, high);
+
+    for (int i = size / 2 - 1; i >= 0 && !obs.cancelled(); i--) {
+        siftDown(data, low, size, i, obs);
+        obs.pace();
+    }
+    for (int end = size - 1; end > 0 && !obs.cancelled(); end--) {
+        swapElements(data, low, low + end, obs);
+        siftDown(data, low, end, 0, obs);
+        obs.pace();
+    }
+}
+
+} // namespace detail
+
+//////////////////////////
+// Bubble Sort
+//////////////////////////
+template <typename T, typename Observer>
+void bubbleSort(T *data, int n, Observer &obs)
+{
+    for (int i = 0; i < n - 1 && !obs.cancelled(); ++i) {
+        bool swapped = false;
+        for (int j = 0; j < n - i - 1; ++j) {
+            obs.compare(j, j + 1);
+            if (data[j] > data[j + 1]) {
+                std::swap(data[j], data[j + 1]);
+                swapped = true;
+
+                obs.swap(j, j + 1);
+
+                obs.pace();
+            }
+        }
+        if (!swapped) break;
+    }
+}
+
+//////////////////////////
+// Selection Sort
+//////////////////////////
+template <typename T, typename Observer>
+void selectionSort(T *data, int n, Observer &obs)
+{
+    for (int i = 0; i < n - 1 && !obs.cancelled(); ++i) {
+        int min_idx = i;
+        for (int j = i + 1; j < n; ++j) {
+            obs.compare(j, min_idx);
+            if (data[j] < data[min_idx]) {
+                min_idx = j;
+            }
+        }
+
+        if (min_idx != i) {
+            std::swap(data[i], data[min_idx]);
+
+            obs.swap(i, min_idx);
+
+            obs.pace();
+        }
+    }
+}
+
+//////////////////////////
+// Insertion Sort
+//////////////////////////
+template <typename T, typename Observer>
+void insertionSort(T *data, int n, Observer &obs)
+{
+    for (int i = 1; i < n && !obs.cancelled(); ++i) {
+        T key = data[i];
+        int j = i - 1;
+
+        while (j >= 0) {
+            obs.compare(j, j + 1);
+            if (data[j] <= key) {
+                break;
+            }
+            data[j + 1] = data[j];
+            obs.write(j + 1, data[j]);
+            j--;
+
+            obs.pace();
+        }
+        data[j + 1] = key;
+        obs.write(j + 1, key);
+
+        obs.pace();
+    }
+}
+
+//////////////////////////
+// Merge Sort
+//////////////////////////
+template <typename T, typename Observer>
+void mergeSort(T *data, int n, Observer &obs, SortArena &arena = SortArena::threadLocal())
+{
+    if (n < 2) {
+        return;
+    }
+
+    SortArena::Scope scope(arena);
+    T *scratch = arena.allocate<T>(n);
+    detail::mergeSortRecursive(data, scratch, 0, n - 1, obs);
+}
+
+//////////////////////////
+// Bottom-Up Merge Sort
+//////////////////////////
+template <typename T, typename Observer>
+void bottomUpMergeSort(T *data, int n, Observer &obs, SortArena &arena = SortArena::threadLocal())
+{
+    if (n < 2) {
+        return;
+    }
+
+    SortArena::Scope scope(arena);
+    T *scratch = arena.allocate<T>(n);
+
+    // Merge runs of width 1, 2, 4, ... without recursion
+    for (int width = 1; width < n && !obs.cancelled(); width *= 2) {
+        for (int left = 0; left < n - width && !obs.cancelled(); left += 2 * width) {
+            const int mid = left + width - 1;
+            const int right = std::min(left + 2 * width - 1, n - 1);
+            detail::mergeRuns(data, scratch, left, mid, right, obs);
+        }
+    }
+}
+
+//////////////////////////
+// Ping-Pong Merge Sort
+//////////////////////////
+// Bottom-up merge sort that alternates between data and a scratch array instead of copying
+// runs out before each merge. The observer sees every merge as writes to the logical array.
+template <typename T, typename Observer>
+void pingPongMergeSort(T *data, int n, Observer &obs, SortArena &arena = SortArena::threadLocal())
+{
+    if (n < 2) {
+        return;
+    }
+
+    SortArena::Scope scope(arena);
+    T *src = data;
+    T *dst = arena.allocate<T>(n);
+
+    for (int width = 1; width < n; width *= 2) {
+        if (obs.cancelled()) {
+            break;
+        }
+        for (int left = 0; left < n; left += 2 * width) {
+            const int mid = std::min(left + width - 1, n - 1);
+            const int right = std::min(left + 2 * width - 1, n - 1);
+            if (mid < right && !obs.cancelled()) {
+                detail::mergeInto(src, dst, left, mid, right, obs);
+            }
+            else {
+                std::copy(src + left, src + right + 1, dst + left); // Unpaired run, or stopping
+            }
+        }
+        std::swap(src, dst);
+    }
+
+    // The observer already saw these values written
+    if (src != data) {
+        std::copy(src, src + n, data);
+    }
+}
+
+//////////////////////////
+// Quick Sort
+//////////////////////////
+template <typename T, typename Observer>
+void quickSort(T *data, int n, Observer &obs)
+{
+    if (n < 2) {
+        return;
+    }
+
+    detail::quickSortIterative(data, 0, n - 1, obs);
+}
+
+//////////////////////////
+// Quick Sort (3-Way)
+//////////////////////////
+// Inputs with few distinct values take one partitioning pass per distinct value instead of
+// degrading towards O(n^2) like the two-way partition does
+template <typename T, typename Observer>
+void quickSortThreeWay(T *data, int n, Observer &obs)
+{
+    if (n < 2) {
+        return;
+    }
+
+    detail::quickSortThreeWayIterative(data, 0, n - 1, obs);
+}
+
+//////////////////////////
+// Heap Sort
+//////////////////////////
+template <typename T, typename Observer>
+void heapSort(T *data, int n, Observer &obs)
+{
+    if (n < 2) {
+        return;
+    }
+
+    detail::heapSortRange(data, 0, n - 1, obs);
+}
+
+//////////////////////////
+// Heap Sort Variants
+//////////////////////////
+// In the binary heap the children of i sit at 2i + 1 and 2i + 2, so once the heap outgrows the
+// cache nearly every level of a sift is a miss. The variants trade that off differently: wider
+// heaps have fewer levels with all children of a node in one cache line, Floyd's bottom-up
+// extraction saves comparisons, and the prefetching binary heap asks for four levels ahead.
+namespace detail {
+
+constexpr long long power(int base, int exponent)
+{
+    return exponent == 0 ? 1 : base * power(base, exponent - 1);
+}
+
+inline void prefetch(const void *address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+// Sift-down in a heap with Arity children per node, children of i at Arity * i + 1 onwards.
+// With PrefetchLevels > 0 the first descendants that many levels below i are prefetched.
+template <int Arity, int PrefetchLevels, typename T, typename Observer>
+void siftDownAligned(T *heap, int size, int i, Observer &obs)
+{
+    // First descendant PrefetchLevels levels below i is at PrefetchSpan * i + PrefetchOffset
+    constexpr long long PrefetchSpan = power(Arity, PrefetchLevels);
+    constexpr long long PrefetchOffset = (PrefetchSpan - 1) / (Arity - 1);
+
+    T value = heap[i];
+    for (;;) {
+        const int first = Arity * i + 1;
+        if (first >= size) {
+            break;
+        }
+        if (PrefetchLevels > 0) {
+            const long long ahead = PrefetchSpan * i + PrefetchOffset;
+            if (ahead < size) {
+                prefetch(heap + ahead);
+            }
+        }
+
+        const int last = std::min(first + Arity, size);
+        int child = first;
+        for (int next = first + 1; next < last; ++next) {
+            obs.compare(child, next);
+            if (heap[child] < heap[next]) {
+                child = next;
+            }
+        }
+        obs.compare(i, child);
+        if (!(value < heap[child])) {
+            break;
+        }
+        heap[i] = heap[child];
+        obs.write(i, heap[i]);
+        i = child;
+    }
+    heap[i] = value;
+    obs.write(i, value);
+}
+
+// Heap sort on a cache-line aligned copy of data. The arena's memory starts on a cache line and
+// the heap starts Arity - 1 elements into it, so the children of every node begin at a multiple
+// of Arity: when Arity * sizeof(T) divides the line size they never straddle two lines. The
+// observer sees heap indices, which are the indices of data.
+template <int Arity, int PrefetchLevels, typename T, typename Observer>
+void alignedHeapSort(T *data, int n, Observer &obs, SortArena &arena)
+{
+    static_assert(Arity >= 2, "a heap needs at least two children per node");
+
+    SortArena::Scope scope(arena);
+    T *heap = arena.allocate<T>(n + Arity - 1) + (Arity - 1);
+    std::copy(data, data + n, heap);
+
+    obs.range(0, n - 1);
+
+    for (int i = (n - 2) / Arity; i >= 0 && !obs.cancelled(); i--) {
+        siftDownAligned<Arity, PrefetchLevels>(heap, n, i, obs);
+        obs.pace();
+    }
+    for (int end = n - 1; end > 0 && !obs.cancelled(); end--) {
+        swapElements(heap, 0, end, obs);
+        siftDownAligned<Arity, PrefetchLevels>(heap, end, 0, obs);
+        obs.pace();
+    }
+
+    // The observer already saw these values written; a cancelled run still holds every element
+    std::copy(heap, heap + n, data);
+}
+
+} // namespace detail
+
+// Arity children per node: log_Arity(n) levels, and with 4 or 8 ints the children of a node
+// fill at most one cache line, for Arity - 1 comparisons per level
+template <int Arity, typename T, typename Observer>
+void dAryHeapSort(T *data, int n, Observer &obs, SortArena &arena = SortArena::threadLocal())
+{
+    if (n < 2) {
+        return;
+    }
+
+    detail::alignedHeapSort<Arity, 0>(data, n, obs, arena);
+}
+
+// The plain binary heap layout on the aligned copy: each pair of siblings shares a cache line,
+// and the 16 descendants four levels down fill exactly one 64-byte line of ints. That line is
+// prefetched while the sift is still four levels above it.
+template <typename T, typename Observer>
+void prefetchHeapSort(T *data, int n, Observer &obs, SortArena &arena = SortArena::threadLocal())
+{
+    if (n < 2) {
+        return;
+    }
+
+    detail::alignedHeapSort<2, 4>(data, n, obs, arena);
+}
+
+// Floyd's bottom-up extraction: the hole left at the root sinks to a leaf along the larger
+// children, one comparison per level instead of two, and the displaced last element climbs
+// back up from there. Being a former leaf it rarely climbs far, so about half the comparisons
+// of heapSort remain.
+template <typename T, typename Observer>
+void bottomUpHeapSort(T *data, int n, Observer &obs)
+{
+    if (n < 2) {
+        return;
+    }
+
+    obs.range(0, n - 1);
+
+    for (int i = n / 2 - 1; i >= 0 && !obs.cancelled(); i--) {
+        detail::siftDown(data, 0, n, i, obs);
+        obs.pace();
+    }
+    for (int end = n - 1; end > 0 && !obs.cancelled(); end--) {
+        T value = data[end];
+        data[end] = data[0];
+        obs.write(end, data[end]);
+
+        int hole = 0;
+        for (int child = 1; child < end; child = 2 * hole + 1) {
+            if (child + 1 < end) {
+                obs.compare(child, child + 1);
+                if (data[child] < data[child + 1]) {
+                    child++;
+                }
+            }
+            data[hole] = data[child];
+            obs.write(hole, data[hole]);
+            hole = child;
+        }
+        while (hole > 0) {
+            const int parent = (hole - 1) / 2;
+            obs.compare(parent, hole);
+            if (!(data[parent] < value)) {
+                break;
+            }
+            data[hole] = data[parent];
+            obs.write(hole, data[hole]);
+            hole = parent;
+        }
+        data[hole] = value;
+        obs.write(hole, value);
+
+        obs.pace();
+    }
+}
+
+//////////////////////////
+// Shell Sort
+//////////////////////////
+// Shell sort is insertion sort over a decreasing series of gaps ending in 1; the series alone
+// decides how fast it is, from quadratic for Shell's halving to close to n log n.
+enum class GapSequence {
+    Shell,     // n/2, n/4, ..., 1                      O(n^2) worst case
+    Hibbard,   // 2^k - 1                               O(n^1.5)
+    Knuth,     // (3^k - 1) / 2 below n / 3             O(n^1.5)
+    Sedgewick, // 1, 4^k + 3 * 2^(k-1) + 1 (1986)       O(n^4/3)
+    Pratt,     // 2^p * 3^q                             O(n log^2 n), but many passes
+    Ciura,     // 1, 4, 10, 23, 57, 132, 301, 701, then * 2.25 (measured, best known)
+    Tokuda,    // ceil(h), h = 2.25 * h + 1 from 1      (measured)
+    Count
+};
+
+// Enough for Pratt's sequence, the longest, below 2^31
+constexpr int MaxShellGaps = 512;
+
+// Writes the gaps of seq below n into gaps in decreasing order and returns their number.
+// n < 2 gets no gaps, anything else ends in 1.
+inline int shellGaps(GapSequence seq, int n, int *gaps)
+{
+    if (n < 2) {
+        return 0;
+    }
+
+    // Collected in increasing order and reversed at the end; long long so the step past n can't overflow
+    int count = 0;
+    const auto add = [&](long long gap) {
+        if (gap < n && count < MaxShellGaps && (count == 0 || gap > gaps[count - 1])) {
+            gaps[count++] = int(gap);
+        }
+    };
+
+    switch (seq) {
+    case GapSequence::Shell:
+        for (int gap = n / 2; gap > 0; gap /= 2) {
+            gaps[count++] = gap;
+        }
+        return count; // Already decreasing
+    case GapSequence::Hibbard:
+        for (long long gap = 1; gap < n; gap = gap * 2 + 1) {
+            add(gap);
+        }
+        break;
+    case GapSequence::Knuth:
+        add(1);
+        for (long long gap = 4; gap <= (n - 1) / 3; gap = gap * 3 + 1) {
+            add(gap);
+        }
+        break;
+    case GapSequence::Sedgewick:
+        add(1);
+        for (int k = 1; ; ++k) {
+            const long long gap = (1LL << (2 * k)) + 3 * (1LL << (k - 1)) + 1;
+            if (gap >= n) {
+                break;
+            }
+            add(gap);
+        }
+        break;
+    case GapSequence::Pratt:
+        for (long long power2 = 1; power2 < n; power2 *= 2) {
+            for (long long gap = power2; gap < n; gap *= 3) {
+                gaps[count++] = int(gap);
+            }
+        }
+        std::sort(gaps, gaps + count);
+        break;
+    case GapSequence::Ciura: {
+        static constexpr int measured[] = {1, 4, 10, 23, 57, 132, 301, 701};
+        for (int gap : measured) {
+            add(gap);
+        }
+        for (double gap = 701 * 2.25; gap < n; gap *= 2.25) {
+            add((long long)gap);
+        }
+        break;
+    }
+    case GapSequence::Tokuda:
+        for (double h = 1.0; h < n; h = 2.25 * h + 1.0) {
+            add((long long)std::ceil(h));
+        }
+        break;
+    default:
+        add(1);
+        break;
+    }
+
+    std::reverse(gaps, gaps + count);
+    return count;
+}
+
+template <typename T, typename Observer>
+void shellSort(T *data, int n, Observer &obs, GapSequence seq = GapSequence::Shell)
+{
+    int gaps[MaxShellGaps];
+    const int gapCount = shellGaps(seq, n, gaps);
+
+    for (int g = 0; g < gapCount && !obs.cancelled(); g++) {
+        const int gap = gaps[g];
+        for (int i = gap; i < n && !obs.cancelled(); i++) {
+            T temp = data[i];
+            int j;
+            for (j = i; j >= gap; j -= gap) {
+                obs.compare(j - gap, j);
+                if (data[j - gap] <= temp) {
+                    break;
+                }
+                data[j] = data[j - gap];
+                obs.write(j, data[j]);
+
+                obs.pace();
+            }
+            data[j] = temp;
+            obs.write(j, temp);
+        }
+    }
+}
+
+//////////////////////////
+// Radix Sort
+//////////////////////////
+// LSD radix sort over DigitBits-wide digits of an unsigned key that orders like the values.
+// The histograms of every digit come from one read of the data, passes whose digit is the
+// same for all keys are skipped, and the passes scatter back and forth between the array
+// and one arena buffer.
+
+// Maps a value to an unsigned key with the same order
+template <typename T, typename Enable = void>
+struct RadixKey;
+
+template <typename T>
+struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+    using Type = typename std::make_unsigned<T>::type;
+
+    static Type toKey(T value)
+    {
+        // Flipping the sign bit puts negative values below positive ones
+        if constexpr (std::is_signed<T>::value) {
+            return Type(value) ^ (Type(1) << (sizeof(T) * 8 - 1));
+        }
+        else {
+            return Type(value);
+        }
+    }
+};
+
+// IEEE floats order like their bits read as sign and magnitude: setting the sign bit of
+// positive values and flipping every bit of negative ones makes that an unsigned order
+template <typename T>
+struct RadixKey<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "float or double");
+    using Type = typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type;
+
+    static Type toKey(T value)
+    {
+        Type bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const Type sign = Type(1) << (sizeof(T) * 8 - 1);
+        return (bits & sign) ? Type(~bits) : Type(bits | sign);
+    }
+};
+
+namespace detail {
+
+template <typename T, int DigitBits>
+constexpr int radixPassCount()
+{
+    return (int(sizeof(typename RadixKey<T>::Type)) * 8 + DigitBits - 1) / DigitBits;
+}
+
+template <int DigitBits, typename Key>
+inline unsigned radixDigit(Key key, int pass)
+{
+    return unsigned(key >> (pass * DigitBits)) & ((1u << DigitBits) - 1);
+}
+
+// Counts of every digit of every pass over [begin, end): counts[pass << DigitBits | digit]
+template <int DigitBits, typename T>
+void radixHistograms(const T *data, int begin, int end, unsigned *counts)
+{
+    constexpr int Passes = radixPassCount<T, DigitBits>();
+    for (int i = begin; i < end; ++i) {
+        const auto key = RadixKey<T>::toKey(data[i]);
+        for (int pass = 0; pass < Passes; ++pass) {
+            counts[pass << DigitBits | radixDigit<DigitBits>(key, pass)]++;
+        }
+    }
+}
+
+} // namespace detail
+
+template <int DigitBits, typename T, typename Observer>
+void lsdRadixSort(T *data, int n, Observer &obs, SortArena &arena = SortArena::threadLocal())
+{
+    static_assert(DigitBits >= 1 && DigitBits <= 16, "digits are 1 to 16 bits wide");
+    constexpr int Radix = 1 << DigitBits;
+    constexpr int Passes = detail::radixPassCount<T, DigitBits>();
+
+    if (n < 2) {
+        return;
+    }
+
+    SortArena::Scope scope(arena);
+    unsigned *counts = arena.allocate<unsigned>(std::size_t(Passes) * Radix);
+    std::fill(counts, counts + std::size_t(Passes) * Radix, 0u);
+    detail::radixHistograms<DigitBits>(data, 0, n, counts);
+
+    T *src = data;
+    T *dst = arena.allocate<T>(n);
+    for (int pass = 0; pass < Passes && !obs.cancelled(); ++pass) {
+        unsigned *offsets = counts + (pass << DigitBits);
+        if (offsets[detail::radixDigit<DigitBits>(RadixKey<T>::toKey(src[0]), pass)] == unsigned(n)) {
+            continue; // Every key has the same digit here, nothing would move
+        }
+
+        // Counts to starting positions
+        unsigned sum = 0;
+        for (int digit = 0; digit < Radix; ++digit) {
+            const unsigned count = offsets[digit];
+            offsets[digit] = sum;
+            sum += count;
+        }
+
+        obs.range(0, n - 1);
+
+        int i = 0;
+        for (; i < n && !obs.cancelled(); ++i) {
+            const int position = int(offsets[detail::radixDigit<DigitBits>(RadixKey<T>::toKey(src[i]), pass)]++);
+            dst[position] = src[i];
+
+            // The chart shows the output array being filled in
+            obs.write(position, src[i]);
+
+            obs.pace();
+        }
+        if (i < n) {
+            break; // Cancelled halfway, src still holds every element
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != data) {
+        std::copy(src, src + n, data);
+    }
+}
+
+template <typename T, typename Observer>
+void radixSort(T *data, int n, Observer &obs, SortArena &arena = SortArena::threadLocal())
+{
+    lsdRadixSort<8>(data, n, obs, arena);
+}
+
+//////////////////////////
+// Bucket Sort
+//////////////////////////
+template <typename T, typename Observer>
+void bucketSort(T *data, int n, Observer &obs)
+{
+    if (n <= 0) {
+        return;
+    }
+
+    // Bucket positions are computed in double, which spans the key range of every element type
+    const double minKey = double(SortKey<T>::get(*std::min_element(data, data + n)));
+    const double maxKey = double(SortKey<T>::get(*std::max_element(data, data + n)));
+
+    int bucketCount = n / 10; // Adjust bucket count as needed
+    bucketCount = std::max(bucketCount, 1);
+    std::vector<std::vector<T>> buckets(bucketCount);
+
+    // Distribute input data into buckets
+    for (int i = 0; i < n && !obs.cancelled(); ++i) {
+        int bucketIndex;
+        if (maxKey == minKey) {
+            bucketIndex = 0; // All elements are identical; assign to the first bucket
+        }
+        else {
+            const double key = double(SortKey<T>::get(data[i]));
+            bucketIndex = std::min(int((key - minKey) / (maxKey - minKey) * (bucketCount - 1)), bucketCount - 1);
+        }
+        buckets[bucketIndex].push_back(data[i]);
+    }
+
+    int index = 0;
+
+    for (int i = 0; i < bucketCount && !obs.cancelled(); ++i) {
+        std::sort(buckets[i].begin(), buckets[i].end());
+
+        for (size_t j = 0; j < buckets[i].size(); ++j) {
+            obs.write(index, buckets[i][j]);
+            data[index++] = buckets[i][j];
+
+            obs.pace();
+        }
+    }
+}
+
+//////////////////////////
+// Counting Sort
+//////////////////////////
+// Counting needs a slot for every key between the smallest and the largest, so a single
+// outlier can ask for gigabytes. Key ranges over the budget below are sorted by radix sort
+// instead, which needs n elements of scratch whatever the keys are.
+namespace detail {
+
+constexpr long long CountingSlotsPerElement = 2;
+constexpr long long CountingMinSlots = 1 << 16; // Always allowed, so small inputs with a modest range still count
+
+// Count slots counting sort may use for n elements, over all its histograms together
+inline long long countingBudget(int n)
+{
+    return std::max(CountingSlotsPerElement * n, CountingMinSlots);
+}
+
+// Distance from the smallest to the largest key of integral type Key, unsigned so that not
+// even the full range of a 64-bit key overflows. Counting sort needs this + 1 slots.
+template <typename Key>
+unsigned long long keySpan(Key min, Key max)
+{
+    using Unsigned = typename std::make_unsigned<Key>::type;
+    return (unsigned long long)Unsigned(Unsigned(max) - Unsigned(min));
+}
+
+} // namespace detail
+
+template <typename T, typename Observer>
+void countingSort(T *data, int n, Observer &obs, SortArena &arena = SortArena::threadLocal())
+{
+    if (n < 2) {
+        return;
+    }
+
+    // Counts need whole-number keys; everything else goes by radix
+    using Key = typename SortKey<T>::Type;
+    if constexpr (!std::is_integral<Key>::value) {
+        radixSort(data, n, obs, arena);
+    }
+    else {
+        const auto extremes = std::minmax_element(data, data + n);
+        const Key min = SortKey<T>::get(*extremes.first);
+        const unsigned long long span = detail::keySpan(min, SortKey<T>::get(*extremes.second));
+        if (span >= (unsigned long long)detail::countingBudget(n)) {
+            radixSort(data, n, obs, arena);
+            return;
+        }
+        const int range = int(span) + 1;
+
+        SortArena::Scope scope(arena);
+        int *count = arena.allocate<int>(range);
+        std::fill(count, count + range, 0);
+        T *output = arena.allocate<T>(n);
+
+        for (int i = 0; i < n && !obs.cancelled(); i++) {
+            count[int(detail::keySpan(min, SortKey<T>::get(data[i])))]++;
+        }
+
+        for (int i = 1; i < range && !obs.cancelled(); i++) {
+            count[i] += count[i - 1];
+        }
+
+        int i = n - 1;
+        for (; i >= 0 && !obs.cancelled(); i--) {
+            const int slot = int(detail::keySpan(min, SortKey<T>::get(data[i])));
+            int position = count[slot] - 1;
+            output[position] = data[i];
+            count[slot]--;
+
+            // The chart shows the output array being filled in
+            obs.write(position, data[i]);
+
+            obs.pace();
+        }
+
+        // Cancelled halfway, data still holds every element
+        if (i < 0) {
+            std::copy(output, output + n, data);
+        }
+    }
+}
+
+//////////////////////////
+// Intro Sort
+//////////////////////////
+// Quicksort with a median-of-three (ninther on large ranges) pivot, insertion sort for small
+// ranges and heap sort for any range where the recursion gets too deep, which bounds the
+// worst case at O(n log n). This is what std::sort does. Pattern-defeating quicksort builds
+// on it: it recognizes already partitioned and equal-heavy ranges, shuffles a few elements
+// after a bad pivot instead of giving up right away, and can partition without branching on
+// comparisons (block partitioning, which keeps mispredictions out of the inner loop).
+namespace detail {
+
+constexpr int IntroInsertionThreshold = 16;
+constexpr int PdqInsertionThreshold = 24;
+constexpr int NintherThreshold = 128;
+constexpr int PartialInsertionLimit = 8;
+constexpr int PartitionBlockSize = 64;
+
+// Moves the pivot to data[low]: median of first, middle and last, or Tukey's ninther (median
+// of three such medians) on large ranges. Either way an element >= pivot ends up behind it,
+// so the partition scans need no bounds checks.
+template <typename T, typename Observer>
+void choosePivot(T *data, int low, int high, Observer &obs)
+{
+    const int size = high - low + 1;
+    const int mid = low + size / 2;
+    if (size > NintherThreshold) {
+        sortThree(data, low, mid, high, obs);
+        sortThree(data, low + 1, mid - 1, high - 1, obs);
+        sortThree(data, low + 2, mid + 1, high - 2, obs);
+        sortThree(data, mid - 1, mid, mid + 1, obs);
+        swapElements(data, low, mid, obs);
+    }
+    else {
+        sortThree(data, mid, low, high, obs);
+    }
+}
+
+template <typename T, typename Observer>
+void insertionSortRange(T *data, int low, int high, Observer &obs)
+{
+    for (int i = low + 1; i <= high; ++i) {
+        T key = data[i];
+        int j = i - 1;
+
+        while (j >= low) {
+            obs.compare(j, j + 1);
+            if (!(key < data[j])) {
+                break;
+            }
+            data[j + 1] = data[j];
+            obs.write(j + 1, data[j]);
+            j--;
+        }
+        data[j + 1] = key;
+        obs.write(j + 1, key);
+
+        obs.pace();
+    }
+}
+
+// Insertion sort that gives up once it has moved more than PartialInsertionLimit elements,
+// true when [low, high] ended up sorted
+template <typename T, typename Observer>
+bool partialInsertionSort(T *data, int low, int high, Observer &obs)
+{
+    int moved = 0;
+    for (int i = low + 1; i <= high; ++i) {
+        obs.compare(i - 1, i);
+        if (!(data[i] < data[i - 1])) {
+            continue;
+        }
+
+        T key = data[i];
+        int j = i - 1;
+        do {
+            data[j + 1] = data[j];
+            obs.write(j + 1, data[j]);
+            j--;
+            if (j < low) {
+                break;
+            }
+            obs.compare(j, j + 1);
+        } while (key < data[j]);
+        data[j + 1] = key;
+        obs.write(j + 1, key);
+
+        obs.pace();
+        moved += i - (j + 1);
+        if (moved > PartialInsertionLimit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Hoare partition around data[low], elements equal to the pivot go right. Returns the pivot's
+// final index; alreadyPartitioned is set when no element had to move.
+template <typename T, typename Observer>
+int partitionRight(T *data, int low, int high, Observer &obs, bool &alreadyPartitioned)
+{
+    const T pivot = data[low];
+    int first = low;
+    int last = high + 1;
+    obs.range(low, high);
+
+    // The pivot choice left an element >= pivot to the right, so this scan stops in range
+    do {
+        ++first;
+        obs.compare(first, low);
+    } while (data[first] < pivot);
+
+    // Only guard the left scan when nothing smaller than the pivot was found yet
+    if (first - 1 == low) {
+        while (first < last) {
+            --last;
+            obs.compare(last, low);
+            if (data[last] < pivot) {
+                break;
+            }
+        }
+    }
+    else {
+        do {
+            --last;
+            obs.compare(last, low);
+        } while (!(data[last] < pivot));
+    }
+
+    alreadyPartitioned = first >= last;
+    while (first < last) {
+        swapElements(data, first, last, obs);
+        obs.pace();
+        do {
+            ++first;
+            obs.compare(first, low);
+        } while (data[first] < pivot);
+        do {
+            --last;
+            obs.compare(last, low);
+        } while (!(data[last] < pivot));
+    }
+
+    const int pivotPos = first - 1;
+    data[low] = data[pivotPos];
+    obs.write(low, data[low]);
+    data[pivotPos] = pivot;
+    obs.write(pivotPos, pivot);
+    return pivotPos;
+}
+
+// Swaps num pairs of misplaced elements found by partitionRightBranchless
+template <typename T, typename Observer>
+void swapOffsets(T *data, int leftBase, int rightBase, const unsigned char *offsetsLeft,
+                 const unsigned char *offsetsRight, int num, bool useSwaps, Observer &obs)
+{
+    if (useSwaps) {
+        // Both sides are used up, plain swaps
+        for (int i = 0; i < num; ++i) {
+            swapElements(data, leftBase + offsetsLeft[i], rightBase - offsetsRight[i], obs);
+        }
+    }
+    else if (num > 0) {
+        // One side has elements left over, a single cycle moves each element once instead of twice
+        int l = leftBase + offsetsLeft[0];
+        int r = rightBase - offsetsRight[0];
+        T temp = data[l];
+        data[l] = data[r];
+        obs.write(l, data[l]);
+        for (int i = 1; i < num; ++i) {
+            l = leftBase + offsetsLeft[i];
+            data[r] = data[l];
+            obs.write(r, data[r]);
+            r = rightBase - offsetsRight[i];
+            data[l] = data[r];
+            obs.write(l, data[l]);
+        }
+        data[r] = temp;
+        obs.write(r, temp);
+    }
+}
+
+// partitionRight with block partitioning: each side first records, for a block of up to 64
+// elements, the offsets of elements on the wrong side, using the comparison result as a number
+// instead of a branch; the recorded elements are then swapped in one go.
+template <typename T, typename Observer>
+int partitionRightBranchless(T *data, int low, int high, Observer &obs, bool &alreadyPartitioned)
+{
+    const T pivot = data[low];
+    int first = low;
+    int last = high + 1;
+    obs.range(low, high);
+
+    do {
+        ++first;
+        obs.compare(first, low);
+    } while (data[first] < pivot);
+
+    if (first - 1 == low) {
+        while (first < last) {
+            --last;
+            obs.compare(last, low);
+            if (data[last] < pivot) {
+                break;
+            }
+        }
+    }
+    else {
+        do {
+            --last;
+            obs.compare(last, low);
+        } while (!(data[last] < pivot));
+    }
+
+    alreadyPartitioned = first >= last;
+    if (!alreadyPartitioned) {
+        swapElements(data, first, last, obs);
+        ++first;
+
+        alignas(64) unsigned char offsetsLeft[PartitionBlockSize];
+        alignas(64) unsigned char offsetsRight[PartitionBlockSize];
+        int leftBase = first;
+        int rightBase = last;
+        int numLeft = 0;
+        int numRight = 0;
+        int startLeft = 0;
+        int startRight = 0;
+
+        while (first < last) {
+            // Refill whichever side ran out of misplaced elements, splitting the rest if both did
+            const int unknown = last - first;
+            const int leftSplit = numLeft == 0 ? (numRight == 0 ? unknown / 2 : unknown) : 0;
+            const int rightSplit = numRight == 0 ? unknown - leftSplit : 0;
+
+            const int leftCount = std::min(leftSplit, PartitionBlockSize);
+            for (int i = 0; i < leftCount; ++i) {
+                offsetsLeft[numLeft] = (unsigned char)i;
+                obs.compare(first, low);
+                numLeft += !(data[first] < pivot);
+                ++first;
+            }
+            const int rightCount = std::min(rightSplit, PartitionBlockSize);
+            for (int i = 0; i < rightCount;) {
+                offsetsRight[numRight] = (unsigned char)++i;
+                --last;
+                obs.compare(last, low);
+                numRight += data[last] < pivot;
+            }
+
+            const int num = std::min(numLeft, numRight);
+            swapOffsets(data, leftBase, rightBase, offsetsLeft + startLeft, offsetsRight + startRight,
+                        num, numLeft == numRight, obs);
+            obs.pace();
+            numLeft -= num;
+            numRight -= num;
+            startLeft += num;
+            startRight += num;
+            if (numLeft == 0) {
+                startLeft = 0;
+                leftBase = first;
+            }
+            if (numRight == 0) {
+                startRight = 0;
+                rightBase = last;
+            }
+        }
+
+        // Misplaced elements left on one side go to the boundary
+        if (numLeft) {
+            while (numLeft--) {
+                swapElements(data, leftBase + offsetsLeft[startLeft + numLeft], --last, obs);
+            }
+            first = last;
+        }
+        if (numRight) {
+            while (numRight--) {
+                swapElements(data, rightBase - offsetsRight[startRight + numRight], first, obs);
+                ++first;
+            }
+        }
+    }
+
+    const int pivotPos = first - 1;
+    data[low] = data[pivotPos];
+    obs.write(low, data[low]);
+    data[pivotPos] = pivot;
+    obs.write(pivotPos, pivot);
+    return pivotPos;
+}
+
+// Partition around data[low] with elements equal to the pivot going left, for ranges whose
+// pivot equals the element before the range: everything equal to it is then already in place
+template <typename T, typename Observer>
+int partitionLeft(T *data, int low, int high, Observer &obs)
+{
+    const T pivot = data[low];
+    int first = low;
+    int last = high + 1;
+    obs.range(low, high);
+
+    do {
+        --last;
+        obs.compare(low, last);
+    } while (pivot < data[last]);
+
+    if (last == high) {
+        while (first < last) {
+            ++first;
+            obs.compare(low, first);
+            if (pivot < data[first]) {
+                break;
+            }
+        }
+    }
+    else {
+        do {
+            ++first;
+            obs.compare(low, first);
+        } while (!(pivot < data[first]));
+    }
+
+    while (first < last) {
+        swapElements(data, first, last, obs);
+        obs.pace();
+        do {
+            --last;
+            obs.compare(low, last);
+        } while (pivot < data[last]);
+        do {
+            ++first;
+            obs.compare(low, first);
+        } while (!(pivot < data[first]));
+    }
+
+    data[low] = data[last];
+    obs.write(low, data[low]);
+    data[last] = pivot;
+    obs.write(last, pivot);
+    return last;
+}
+
+template <typename T, typename Observer>
+void introSortLoop(T *data, int low, int high, int depthLimit, Observer &obs)
+{
+    // Recurse into the smaller side and loop on the larger one, the stack stays O(log n)
+    while (high - low + 1 > IntroInsertionThreshold && !obs.cancelled()) {
+        if (depthLimit == 0) {
+            // Quicksort is going quadratic here: heap sort this range, and only this range
+            heapSortRange(data, low, high, obs);
+            return;
+        }
+        depthLimit--;
+
+        choosePivot(data, low, high, obs);
+        bool alreadyPartitioned;
+        const int pivotPos = partitionRight(data, low, high, obs, alreadyPartitioned);
+        obs.pace();
+
+        if (pivotPos - low < high - pivotPos) {
+            introSortLoop(data, low, pivotPos - 1, depthLimit, obs);
+            low = pivotPos + 1;
+        }
+        else {
+            introSortLoop(data, pivotPos + 1, high, depthLimit, obs);
+            high = pivotPos - 1;
+        }
+    }
+
+    if (!obs.cancelled()) {
+        insertionSortRange(data, low, high, obs);
+    }
+}
+
+// Breaks up patterns that made the last pivot bad by swapping a few elements on each side
+template <typename T, typename Observer>
+void breakPatterns(T *data, int low, int high, int pivotPos, Observer &obs)
+{
+    const int leftSize = pivotPos - low;
+    const int rightSize = high - pivotPos;
+
+    if (leftSize >= PdqInsertionThreshold) {
+        swapElements(data, low, low + leftSize / 4, obs);
+        swapElements(data, pivotPos - 1, pivotPos - leftSize / 4, obs);
+        if (leftSize > NintherThreshold) {
+            swapElements(data, low + 1, low + (leftSize / 4 + 1), obs);
+            swapElements(data, low + 2, low + (leftSize / 4 + 2), obs);
+            swapElements(data, pivotPos - 2, pivotPos - (leftSize / 4 + 1), obs);
+            swapElements(data, pivotPos - 3, pivotPos - (leftSize / 4 + 2), obs);
+        }
+    }
+    if (rightSize >= PdqInsertionThreshold) {
+        swapElements(data, pivotPos + 1, pivotPos + (1 + rightSize / 4), obs);
+        swapElements(data, high, high + 1 - rightSize / 4, obs);
+        if (rightSize > NintherThreshold) {
+            swapElements(data, pivotPos + 2, pivotPos + (2 + rightSize / 4), obs);
+            swapElements(data, pivotPos + 3, pivotPos + (3 + rightSize / 4), obs);
+            swapElements(data, high - 1, high - rightSize / 4, obs);
+            swapElements(data, high - 2, high - (1 + rightSize / 4), obs);
+        }
+    }
+}
+
+template <bool Branchless, typename T, typename Observer>
+void pdqSortLoop(T *data, int low, int high, int badAllowed, bool leftmost, Observer &obs)
+{
+    while (!obs.cancelled()) {
+        const int size = high - low + 1;
+        if (size < PdqInsertionThreshold) {
+            insertionSortRange(data, low, high, obs);
+            return;
+        }
+
+        choosePivot(data, low, high, obs);
+
+        // The element before the range was an earlier pivot. If it equals this one, no element
+        // here is smaller: gather the equal ones on the left and only carry on with the rest.
+        if (!leftmost) {
+            obs.compare(low - 1, low);
+            if (!(data[low - 1] < data[low])) {
+                low = partitionLeft(data, low, high, obs) + 1;
+                obs.pace();
+                continue;
+            }
+        }
+
+        bool alreadyPartitioned;
+        const int pivotPos = Branchless ? partitionRightBranchless(data, low, high, obs, alreadyPartitioned)
+                                        : partitionRight(data, low, high, obs, alreadyPartitioned);
+        obs.pace();
+
+        const int leftSize = pivotPos - low;
+        const int rightSize = high - pivotPos;
+        if (leftSize < size / 8 || rightSize < size / 8) {
+            // Too many bad pivots, this range is adversarial: fall back to heap sort
+            if (--badAllowed == 0) {
+                heapSortRange(data, low, high, obs);
+                return;
+            }
+            breakPatterns(data, low, high, pivotPos, obs);
+        }
+        else if (alreadyPartitioned && partialInsertionSort(data, low, pivotPos - 1, obs)
+                 && partialInsertionSort(data, pivotPos + 1, high, obs)) {
+            // Nothing moved and both sides were nearly sorted already
+            return;
+        }
+
+        pdqSortLoop<Branchless>(data, low, pivotPos - 1, badAllowed, leftmost, obs);
+        low = pivotPos + 1;
+        leftmost = false;
+    }
+}
+
+} // namespace detail
+
+template <typename T, typename Observer>
+void introSort(T *data, int n, Observer &obs)
+{
+    if (n < 2) {
+        return;
+    }
+
+    detail::introSortLoop(data, 0, n - 1, 2 * detail::log2Floor(n), obs);
+}
+
+// Pattern-defeating quicksort (Orson Peters). Branchless selects block partitioning, which pays
+// off for cheap comparisons such as the built-in arithmetic types.
+template <bool Branchless, typename T, typename Observer>
+void pdqSort(T *data, int n, Observer &obs)
+{
+    if (n < 2) {
+        return;
+    }
+
+    detail::pdqSortLoop<Branchless>(data, 0, n - 1, detail::log2Floor(n), true, obs);
+}
+
+} // namespace sorting
+
+#endif // SORTKERNELS_H
@@ -0,0 +1,106 @@
+#ifndef SORTSTEP_H
+#define SORTSTEP_H
+
+#include <QVector>
+#include <QMetaType>
+#include <utility> // For std::swap
+
+// One visual event produced by a sorting algorithm.
+// Workers send these in batches instead of copying the whole array per step.
+struct SortStep
+{
+    enum Kind : quint8 {
+        Swap,    // a <-> b
+        Write,   // data[a] = b
+        Compare, // a and b were compared (highlight only)
+        Range    // algorithm is working on [a, b] (highlight only)
+    };
+
+    SortStep() = default;
+    SortStep(Kind kind, int a, int b, quint8 owner = 0) : kind(kind), owner(owner), a(a), b(b) {}
+
+    Kind kind = Compare;
+    quint8 owner = 0; // Range steps of parallel sorts: pool thread + 1, 0 when unknown
+    int a = 0;
+    int b = 0;
+};
+
+Q_DECLARE_METATYPE(SortStep)
+
+// Apply one step to the array it was recorded on
+inline void applyStep(int *values, const SortStep &step)
+{
+    switch (step.kind) {
+    case SortStep::Swap:
+        std::swap(values[step.a], values[step.b]);
+        break;
+    case SortStep::Write:
+        values[step.a] = step.b;
+        break;
+    case SortStep::Compare:
+    case SortStep::Range:
+        break;
+    }
+}
+
+// Replay a batch of steps onto a mirror of the array being sorted
+inline void applySteps(QVector<int> &data, const QVector<SortStep> &steps)
+{
+    int *values = data.data(); // Detach once, not per step
+    for (const SortStep &step : steps) {
+        applyStep(values, step);
+    }
+}
+
+// Indices touched by the last few steps of a batch, used for highlighting.
+// Eight steps cover one vector block of the SIMD sorts.
+inline QVector<int> recentIndices(const QVector<SortStep> &steps, int maxSteps = 8)
+{
+    QVector<int> indices;
+    for (auto it = steps.crbegin(); it != steps.crend() && maxSteps > 0; ++it) {
+        switch (it->kind) {
+        case SortStep::Swap:
+        case SortStep::Compare:
+            indices << it->a << it->b;
+            --maxSteps;
+            break;
+        case SortStep::Write:
+            indices << it->a;
+            --maxSteps;
+            break;
+        case SortStep::Range:
+            break;
+        }
+    }
+    return indices;
+}
+
+// Mark which pool thread handled each index, from the owner of Range steps
+inline void applyOwners(QVector<quint8> &owners, const QVector<SortStep> &steps)
+{
+    for (const SortStep &step : steps) {
+        if (step.kind == SortStep::Range && step.owner != 0) {
+            const int low = qMax(0, step.a);
+            const int high = qMin(int(owners.size()) - 1, step.b);
+            for (int i = low; i <= high; ++i) {
+                owners[i] = step.owner;
+            }
+        }
+    }
+}
+
+// Sorting kernel observer that keeps every step in memory (tests, profiling, replay)
+struct RecordingObserver
+{
+    QVector<SortStep> steps;
+
+    void compare(int i, int j) { steps.append(SortStep{SortStep::Compare, i, j}); }
+    void swap(int i, int j) { steps.append(SortStep{SortStep::Swap, i, j}); }
+    void write(int i, int value) { steps.append(SortStep{SortStep::Write, i, value}); }
+    void range(int low, int high) { steps.append(SortStep{SortStep::Range, low, high}); }
+    void owner(int low, int high, int thread) { steps.append(SortStep{SortStep::Range, low, high, quint8(thread + 1)}); }
+    void pace() {}
+    bool cancelled() const { return false; }
+};
+
+#endif // SORTSTEP_H
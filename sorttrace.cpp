@@ -0,0 +1,32 @@
+#include "sorttrace.h"
+
+SortTrace::SortTrace(const QString &algorithm, const QVector<int> &initialData)
+    : m_algorithm(algorithm)
+    , m_initialData(initialData)
+    , m_checkpointInterval(checkpointIntervalFor(initialData.size()))
+    , m_current(initialData)
+{
+    m_checkpoints.append(m_initialData);
+}
+
+TraceCursor SortTrace::checkpointCursor(int index) const
+{
+    TraceCursor cursor;
+    cursor.offset = qint64(index) * m_checkpointInterval;
+    return cursor;
+}
+
+SortStep SortTrace::readStep(TraceCursor &cursor) const
+{
+    return m_steps[cursor.offset++];
+}
+
+void SortTrace::append(const SortStep &step)
+{
+    m_steps.append(step);
+    applyStep(m_current.data(), step);
+
+    if (m_steps.size() % m_checkpointInterval == 0) {
+        m_checkpoints.append(m_current); // Shared until the next step detaches m_current
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef SORTTRACE_H
+#define SORTTRACE_H
+
+#include <QVector>
+#include <QString>
+#include "tracesource.h"
+
+// Complete record of one sorting run kept in memory: the input and every swap/write applied
+// to it, plus periodic snapshots (checkpoints) so playback can seek without replaying from the start.
+class SortTrace : public TraceSource
+{
+public:
+    explicit SortTrace(const QString &algorithm = {}, const QVector<int> &initialData = {});
+
+    QString algorithm() const override { return m_algorithm; }
+    QVector<int> initialData() const override { return m_initialData; }
+    int length() const override { return m_steps.size(); }
+
+    int checkpointInterval() const override { return m_checkpointInterval; }
+    int checkpointCount() const override { return m_checkpoints.size(); }
+    QVector<int> checkpoint(int index) const override { return m_checkpoints[index]; }
+
+    TraceCursor checkpointCursor(int index) const override;
+    SortStep readStep(TraceCursor &cursor) const override;
+
+    // Recording
+    void append(const SortStep &step);
+
+    // One snapshot per n steps keeps the checkpoints about as large as the steps themselves
+    static int checkpointIntervalFor(int size) { return qMax(1024, size); }
+
+private:
+    QString m_algorithm;
+    QVector<int> m_initialData;
+    QVector<SortStep> m_steps;
+    QVector<QVector<int>> m_checkpoints;
+    int m_checkpointInterval;
+
+    // State after all recorded steps, snapshotted at every checkpoint
+    QVector<int> m_current;
+};
+
+// Sorting kernel observer that feeds a trace sink (SortTrace or TraceFileWriter).
+// Only steps that change the array are kept.
+template <typename Sink>
+class TraceRecorder
+{
+public:
+    explicit TraceRecorder(Sink &sink) : m_sink(sink) {}
+
+    void compare(int, int) {}
+    void swap(int i, int j) { m_sink.append(SortStep{SortStep::Swap, i, j}); }
+    void write(int i, int value) { m_sink.append(SortStep{SortStep::Write, i, value}); }
+    void range(int, int) {}
+    void owner(int, int, int) {}
+    void pace() {}
+    bool cancelled() const { return false; }
+
+private:
+    Sink &m_sink;
+};
+
+#endif // SORTTRACE_H
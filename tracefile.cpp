@@ -0,0 +1,325 @@
+#include "tracefile.h"
+#include "sorttrace.h"
+#include <QtEndian>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+const char FileMagic[8] = {'S', 'O', 'R', 'T', 'T', 'R', 'C', '1'};
+const char IndexMagic[8] = {'S', 'O', 'R', 'T', 'I', 'D', 'X', '1'};
+const quint32 FileVersion = 1;
+const qint64 TrailerSize = 8 + 8 + 8;
+const qint64 BufferFlushSize = 1 << 20;
+
+enum RecordKind : quint64 {
+    SwapRecord = 0,
+    WriteRecord = 1,
+    KeyframeRecord = 2
+};
+
+quint64 zigzagEncode(qint64 value)
+{
+    return (quint64(value) << 1) ^ quint64(value >> 63);
+}
+
+qint64 zigzagDecode(quint64 value)
+{
+    return qint64(value >> 1) ^ -qint64(value & 1);
+}
+
+void appendVarint(QByteArray &buffer, quint64 value)
+{
+    while (value >= 0x80) {
+        buffer.append(char(value | 0x80));
+        value >>= 7;
+    }
+    buffer.append(char(value));
+}
+
+template <typename T>
+void appendLittleEndian(QByteArray &buffer, T value)
+{
+    char bytes[sizeof(T)];
+    qToLittleEndian(value, bytes);
+    buffer.append(bytes, sizeof(T));
+}
+
+void appendInts(QByteArray &buffer, const QVector<int> &values)
+{
+    const qsizetype start = buffer.size();
+    buffer.resize(start + values.size() * qsizetype(sizeof(qint32)));
+    qToLittleEndian<qint32>(values.constData(), values.size(), buffer.data() + start);
+}
+
+template <typename T>
+T readLittleEndian(const uchar *data)
+{
+    return qFromLittleEndian<T>(data);
+}
+
+} // namespace
+
+//////////////////////////
+// TraceFileWriter
+//////////////////////////
+TraceFileWriter::~TraceFileWriter()
+{
+    if (m_file.isOpen()) {
+        close();
+    }
+}
+
+bool TraceFileWriter::open(const QString &path, const QString &algorithm, quint64 seed, const QVector<int> &initialData)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    m_current = initialData;
+    m_keyframeInterval = SortTrace::checkpointIntervalFor(initialData.size());
+    m_keyframeOffsets.clear();
+    m_stepCount = 0;
+    m_previousIndex = 0;
+
+    const QByteArray name = algorithm.toUtf8();
+    m_buffer.clear();
+    m_buffer.append(FileMagic, sizeof(FileMagic));
+    appendLittleEndian<quint32>(m_buffer, FileVersion);
+    appendLittleEndian<quint32>(m_buffer, 0); // Flags, reserved
+    appendLittleEndian<quint64>(m_buffer, seed);
+    appendLittleEndian<quint32>(m_buffer, quint32(initialData.size()));
+    appendLittleEndian<quint32>(m_buffer, quint32(m_keyframeInterval));
+    appendLittleEndian<quint32>(m_buffer, quint32(name.size()));
+    m_buffer.append(name);
+    appendInts(m_buffer, initialData);
+
+    // Keyframe 0 is the input written above
+    m_keyframeOffsets.append(quint64(streamPosition()));
+    return flushBuffer();
+}
+
+void TraceFileWriter::append(const SortStep &step)
+{
+    if (step.kind != SortStep::Swap && step.kind != SortStep::Write) {
+        return; // Highlight-only steps are not stored
+    }
+
+    const quint64 kind = (step.kind == SortStep::Swap) ? SwapRecord : WriteRecord;
+    appendVarint(m_buffer, zigzagEncode(qint64(step.a) - m_previousIndex) << 2 | kind);
+    appendVarint(m_buffer, zigzagEncode(qint64(step.b) - step.a));
+    m_previousIndex = step.a;
+
+    applyStep(m_current.data(), step);
+    m_stepCount++;
+
+    if (m_stepCount % m_keyframeInterval == 0) {
+        writeKeyframe();
+    }
+    if (m_buffer.size() >= BufferFlushSize) {
+        flushBuffer();
+    }
+}
+
+void TraceFileWriter::writeKeyframe()
+{
+    appendVarint(m_buffer, KeyframeRecord);
+    appendInts(m_buffer, m_current);
+    m_keyframeOffsets.append(quint64(streamPosition()));
+    m_previousIndex = 0;
+}
+
+bool TraceFileWriter::flushBuffer()
+{
+    if (m_buffer.isEmpty()) {
+        return true;
+    }
+    const bool ok = m_file.write(m_buffer) == m_buffer.size();
+    m_buffer.clear();
+    return ok;
+}
+
+bool TraceFileWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    const quint64 indexOffset = quint64(streamPosition());
+    appendLittleEndian<quint32>(m_buffer, quint32(m_keyframeOffsets.size()));
+    for (quint64 offset : std::as_const(m_keyframeOffsets)) {
+        appendLittleEndian<quint64>(m_buffer, offset);
+    }
+    appendLittleEndian<quint64>(m_buffer, quint64(m_stepCount));
+    appendLittleEndian<quint64>(m_buffer, indexOffset);
+    m_buffer.append(IndexMagic, sizeof(IndexMagic));
+
+    const bool ok = flushBuffer();
+    m_file.close();
+    m_current.clear();
+    return ok && m_file.error() == QFileDevice::NoError;
+}
+
+bool TraceFileWriter::save(const TraceSource &source, const QString &path, quint64 seed)
+{
+    TraceFileWriter writer;
+    if (!writer.open(path, source.algorithm(), seed, source.initialData())) {
+        return false;
+    }
+
+    TraceCursor cursor = source.checkpointCursor(0);
+    const int length = source.length();
+    for (int i = 0; i < length; ++i) {
+        writer.append(source.readStep(cursor));
+    }
+    return writer.close();
+}
+
+//////////////////////////
+// TraceFile
+//////////////////////////
+TraceFile::~TraceFile()
+{
+    if (m_map) {
+        m_file.unmap(const_cast<uchar *>(m_map));
+    }
+}
+
+QSharedPointer<TraceFile> TraceFile::open(const QString &path, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        return QSharedPointer<TraceFile>();
+    };
+
+    QSharedPointer<TraceFile> trace(new TraceFile);
+    trace->m_file.setFileName(path);
+    if (!trace->m_file.open(QIODevice::ReadOnly)) {
+        return fail(trace->m_file.errorString());
+    }
+
+    trace->m_size = trace->m_file.size();
+    const qint64 fixedHeaderSize = 36;
+    if (trace->m_size < fixedHeaderSize + TrailerSize) {
+        return fail("File is too small to be a trace");
+    }
+
+    trace->m_map = trace->m_file.map(0, trace->m_size);
+    if (!trace->m_map) {
+        return fail(trace->m_file.errorString());
+    }
+    const uchar *map = trace->m_map;
+
+    // Header
+    if (std::memcmp(map, FileMagic, sizeof(FileMagic)) != 0) {
+        return fail("Not a trace file");
+    }
+    if (readLittleEndian<quint32>(map + 8) != FileVersion) {
+        return fail("Unsupported trace file version");
+    }
+    trace->m_seed = readLittleEndian<quint64>(map + 16);
+    const quint32 elementCount = readLittleEndian<quint32>(map + 24);
+    const quint32 keyframeInterval = readLittleEndian<quint32>(map + 28);
+    const quint32 nameLength = readLittleEndian<quint32>(map + 32);
+
+    const qint64 streamStart = fixedHeaderSize + qint64(nameLength) + qint64(elementCount) * 4;
+    if (elementCount > quint32(INT_MAX) || keyframeInterval == 0 || keyframeInterval > quint32(INT_MAX)
+        || streamStart > trace->m_size - TrailerSize) {
+        return fail("Corrupt trace header");
+    }
+    trace->m_elementCount = int(elementCount);
+    trace->m_keyframeInterval = int(keyframeInterval);
+    trace->m_algorithm = QString::fromUtf8(reinterpret_cast<const char *>(map + fixedHeaderSize), nameLength);
+
+    // Trailer and keyframe index
+    const uchar *trailer = map + trace->m_size - TrailerSize;
+    if (std::memcmp(trailer + 16, IndexMagic, sizeof(IndexMagic)) != 0) {
+        return fail("Trace file is incomplete (was the recording interrupted?)");
+    }
+    const quint64 stepCount = readLittleEndian<quint64>(trailer);
+    const quint64 indexOffset = readLittleEndian<quint64>(trailer + 8);
+    if (stepCount > quint64(INT_MAX) || indexOffset < quint64(streamStart)
+        || indexOffset + 4 > quint64(trace->m_size - TrailerSize)) {
+        return fail("Corrupt trace index");
+    }
+    trace->m_length = int(stepCount);
+    trace->m_streamEnd = qint64(indexOffset);
+
+    const quint32 keyframeCount = readLittleEndian<quint32>(map + indexOffset);
+    if (keyframeCount == 0 || indexOffset + 4 + quint64(keyframeCount) * 8 > quint64(trace->m_size - TrailerSize)) {
+        return fail("Corrupt trace index");
+    }
+    trace->m_keyframeOffsets.resize(keyframeCount);
+    for (quint32 i = 0; i < keyframeCount; ++i) {
+        const quint64 offset = readLittleEndian<quint64>(map + indexOffset + 4 + i * 8);
+        if (offset < quint64(streamStart) || offset > indexOffset) {
+            return fail("Corrupt trace index");
+        }
+        trace->m_keyframeOffsets[i] = offset;
+    }
+
+    return trace;
+}
+
+QVector<int> TraceFile::checkpoint(int index) const
+{
+    // Every keyframe snapshot sits right before the records that follow it
+    const qint64 snapshot = qint64(m_keyframeOffsets[index]) - qint64(m_elementCount) * 4;
+    QVector<int> values(m_elementCount);
+    qFromLittleEndian<qint32>(m_map + snapshot, m_elementCount, values.data());
+    return values;
+}
+
+TraceCursor TraceFile::checkpointCursor(int index) const
+{
+    TraceCursor cursor;
+    cursor.offset = qint64(m_keyframeOffsets[index]);
+    cursor.previousIndex = 0;
+    return cursor;
+}
+
+bool TraceFile::readVarint(qint64 &offset, quint64 &value) const
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && offset < m_streamEnd; shift += 7) {
+        const uchar byte = m_map[offset++];
+        value |= quint64(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SortStep TraceFile::readStep(TraceCursor &cursor) const
+{
+    quint64 tag = 0;
+    while (readVarint(cursor.offset, tag)) {
+        const quint64 kind = tag & 3;
+        if (kind == KeyframeRecord) {
+            // Steps continue after the snapshot with fresh delta state
+            cursor.offset += qint64(m_elementCount) * 4;
+            cursor.previousIndex = 0;
+            continue;
+        }
+
+        quint64 operand = 0;
+        if (!readVarint(cursor.offset, operand)) {
+            break;
+        }
+        const int a = int(cursor.previousIndex + zigzagDecode(tag >> 2));
+        const int b = int(a + zigzagDecode(operand));
+        cursor.previousIndex = a;
+
+        if (a < 0 || a >= m_elementCount || (kind == SwapRecord && (b < 0 || b >= m_elementCount))) {
+            break;
+        }
+        return SortStep{kind == SwapRecord ? SortStep::Swap : SortStep::Write, a, b};
+    }
+
+    // Reading past the end or a corrupt record: a step that changes nothing
+    return SortStep{SortStep::Compare, 0, 0};
+}
@@ -0,0 +1,96 @@
+#ifndef TRACEFILE_H
+#define TRACEFILE_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QVector>
+#include <QString>
+#include <QSharedPointer>
+#include "tracesource.h"
+
+// Binary trace file (.strace), all integers little-endian:
+//
+//   header   "SORTTRC1", u32 version, u32 flags, u64 seed, u32 element count n,
+//            u32 keyframe interval, u32 name length, UTF-8 algorithm name, i32[n] input
+//   records  varint tag = zigzag(index delta) << 2 | kind, where kind is 0 = swap, 1 = write;
+//            followed by varint zigzag(b - a). The index delta is relative to the previous
+//            record's first index and restarts at 0 after every keyframe.
+//            Kind 2 is a keyframe: i32[n] array snapshot, written every interval steps.
+//   index    u32 keyframe count, u64[count] offset of the first record after each keyframe
+//            (keyframe 0 is the input, its offset is the start of the records)
+//   trailer  u64 step count, u64 index offset, "SORTIDX1"
+//
+// Swap and write records are usually 2-4 bytes, against 12 for an in-memory SortStep.
+
+// Streams a trace to disk while the algorithm runs. Only the write buffer and one copy of
+// the array (for keyframes) are kept in memory.
+class TraceFileWriter
+{
+public:
+    TraceFileWriter() = default;
+    ~TraceFileWriter();
+
+    bool open(const QString &path, const QString &algorithm, quint64 seed, const QVector<int> &initialData);
+    void append(const SortStep &step);
+    // Writes the keyframe index and trailer; the file is unusable until this succeeds
+    bool close();
+    QString errorString() const { return m_file.errorString(); }
+
+    // Write a whole recorded run to a file
+    static bool save(const TraceSource &source, const QString &path, quint64 seed = 0);
+
+private:
+    QFile m_file;
+    QByteArray m_buffer;
+    QVector<int> m_current;
+    QVector<quint64> m_keyframeOffsets;
+    qint64 m_stepCount = 0;
+    int m_keyframeInterval = 0;
+    int m_previousIndex = 0;
+
+    qint64 streamPosition() const { return m_file.pos() + m_buffer.size(); }
+    void writeKeyframe();
+    bool flushBuffer();
+};
+
+// Read-only trace file mapped into memory. Pages are only loaded as playback touches them,
+// so traces far larger than RAM can be played back and seeked.
+class TraceFile : public TraceSource
+{
+public:
+    ~TraceFile() override;
+
+    static QSharedPointer<TraceFile> open(const QString &path, QString *error = nullptr);
+
+    quint64 seed() const { return m_seed; }
+
+    QString algorithm() const override { return m_algorithm; }
+    QVector<int> initialData() const override { return checkpoint(0); }
+    int length() const override { return m_length; }
+
+    int checkpointInterval() const override { return m_keyframeInterval; }
+    int checkpointCount() const override { return m_keyframeOffsets.size(); }
+    QVector<int> checkpoint(int index) const override;
+
+    TraceCursor checkpointCursor(int index) const override;
+    SortStep readStep(TraceCursor &cursor) const override;
+
+private:
+    TraceFile() = default;
+
+    QFile m_file;
+    const uchar *m_map = nullptr;
+    qint64 m_size = 0;
+
+    QString m_algorithm;
+    quint64 m_seed = 0;
+    int m_elementCount = 0;
+    int m_keyframeInterval = 0;
+    int m_length = 0;
+    qint64 m_streamEnd = 0; // Start of the keyframe index
+    QVector<quint64> m_keyframeOffsets;
+
+    bool readVarint(qint64 &offset, quint64 &value) const;
+};
+
+#endif // TRACEFILE_H
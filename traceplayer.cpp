@@ -0,0 +1,66 @@
+#include "traceplayer.h"
+#include <QtGlobal>
+
+void TracePlayer::setTrace(const QSharedPointer<const TraceSource> &trace)
+{
+    m_trace = trace;
+    m_data = trace ? trace->initialData() : QVector<int>();
+    m_cursor = trace ? trace->checkpointCursor(0) : TraceCursor();
+    m_position = 0;
+    m_length = trace ? trace->length() : 0;
+    m_recentSteps.clear();
+}
+
+void TracePlayer::reset()
+{
+    setTrace({});
+}
+
+void TracePlayer::seek(int position)
+{
+    if (!m_trace) {
+        return;
+    }
+
+    position = qBound(0, position, m_length);
+    if (position == m_position) {
+        return;
+    }
+
+    const int interval = m_trace->checkpointInterval();
+    const int checkpoint = qMin(position / interval, m_trace->checkpointCount() - 1);
+    const int checkpointPosition = checkpoint * interval;
+
+    // Moving forward from where we are is cheaper than restoring a checkpoint
+    if (position < m_position || checkpointPosition > m_position) {
+        m_data = m_trace->checkpoint(checkpoint);
+        m_cursor = m_trace->checkpointCursor(checkpoint);
+        m_position = checkpointPosition;
+        m_recentSteps.clear();
+    }
+
+    applySteps(position - m_position);
+}
+
+void TracePlayer::applySteps(int count)
+{
+    int *values = m_data.data();
+    for (int i = 0; i < count; ++i) {
+        const SortStep step = m_trace->readStep(m_cursor);
+        applyStep(values, step);
+
+        // Only the tail matters for highlighting
+        if (count - i <= RecentStepCount) {
+            if (m_recentSteps.size() == RecentStepCount) {
+                m_recentSteps.removeFirst();
+            }
+            m_recentSteps.append(step);
+        }
+    }
+    m_position += count;
+}
+
+QVector<int> TracePlayer::recentIndices() const
+{
+    return ::recentIndices(m_recentSteps, RecentStepCount);
+}
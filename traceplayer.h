@@ -0,0 +1,45 @@
+#ifndef TRACEPLAYER_H
+#define TRACEPLAYER_H
+
+#include <QVector>
+#include <QSharedPointer>
+#include "tracesource.h"
+
+// Plays a recorded trace back at any position.
+// Seeking restores the nearest checkpoint and applies at most one checkpoint interval of steps.
+class TracePlayer
+{
+public:
+    void setTrace(const QSharedPointer<const TraceSource> &trace);
+    void reset();
+
+    bool isValid() const { return !m_trace.isNull(); }
+    const QSharedPointer<const TraceSource> &trace() const { return m_trace; }
+    int position() const { return m_position; }
+    int length() const { return m_length; }
+    bool atEnd() const { return m_position >= m_length; }
+
+    void seek(int position);
+    void stepForward() { seek(m_position + 1); }
+    void stepBack() { seek(m_position - 1); }
+
+    // Array after the first position() steps
+    const QVector<int> &data() const { return m_data; }
+    // Indices changed by the last few steps before position()
+    QVector<int> recentIndices() const;
+
+private:
+    QSharedPointer<const TraceSource> m_trace;
+    QVector<int> m_data;
+    TraceCursor m_cursor;
+    int m_position = 0;
+    int m_length = 0;
+
+    // Last steps applied, for highlighting
+    QVector<SortStep> m_recentSteps;
+    static constexpr int RecentStepCount = 8;
+
+    void applySteps(int count);
+};
+
+#endif // TRACEPLAYER_H
@@ -0,0 +1,40 @@
+#ifndef TRACESOURCE_H
+#define TRACESOURCE_H
+
+#include <QVector>
+#include <QString>
+#include <QSharedPointer>
+#include <QMetaType>
+#include "sortstep.h"
+
+// Position in a trace's step stream. Only meaningful to the source that produced it.
+struct TraceCursor
+{
+    qint64 offset = 0;
+    int previousIndex = 0; // Delta-decoding state for file traces
+};
+
+// Read-only recorded run that TracePlayer can play back: the in-memory SortTrace
+// or a memory-mapped trace file.
+class TraceSource
+{
+public:
+    virtual ~TraceSource() = default;
+
+    virtual QString algorithm() const = 0;
+    virtual QVector<int> initialData() const = 0;
+    virtual int length() const = 0;
+
+    // Array state after checkpoint * checkpointInterval() steps; checkpoint 0 is the input
+    virtual int checkpointInterval() const = 0;
+    virtual int checkpointCount() const = 0;
+    virtual QVector<int> checkpoint(int index) const = 0;
+
+    // Cursor at the first step after a checkpoint; readStep() returns a step and advances it
+    virtual TraceCursor checkpointCursor(int index) const = 0;
+    virtual SortStep readStep(TraceCursor &cursor) const = 0;
+};
+
+Q_DECLARE_METATYPE(QSharedPointer<TraceSource>)
+
+#endif // TRACESOURCE_H
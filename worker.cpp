@@ -1,588 +1,257 @@
 #include "worker.h"
+#include "tracefile.h"
 #include <QThread>
 #include <QDebug>
 #include <algorithm>
-#include <cmath> // For log function
 
-Worker::Worker(QObject *parent) : QObject(parent), m_chartIndex(-1), m_speed(50)
+// Qt side of the sorting kernels: records steps, waits for the pacing budget between visible
+// steps, blocks while paused and stops when the run is cancelled.
+class Worker::StepObserver
 {
-}
-
-void Worker::setData(const QVector<int> &data)
-{
-    m_data = data;
-}
-
-void Worker::setAlgorithm(const QString &algorithmName)
-{
-    m_algorithmName = algorithmName;
-}
-
-void Worker::setChartIndex(int index)
-{
-    m_chartIndex = index;
-}
-
-void Worker::setSpeed(int speed)
-{
-    // Clamp speed between 1 and 100 to prevent invalid delay values
-    speed = qBound(1, speed, 100);
-    m_speed.storeRelease(speed);
-}
-
-void Worker::process()
-{
-    qDebug() << "Worker" << m_chartIndex << ": Starting process with algorithm" << m_algorithmName;
-    runAlgorithm();
-    emit finished();
-    qDebug() << "Worker" << m_chartIndex << ": Finished process";
-}
-
-void Worker::runAlgorithm()
-{
-    if (m_algorithmName == "Bubble Sort") {
-        bubbleSort();
-    }
-    else if (m_algorithmName == "Selection Sort") {
-        selectionSort();
-    }
-    else if (m_algorithmName == "Insertion Sort") {
-        insertionSort();
-    }
-    else if (m_algorithmName == "Merge Sort") {
-        mergeSort();
-    }
-    else if (m_algorithmName == "Quick Sort") {
-        quickSort();
-    }
-    else if (m_algorithmName == "Heap Sort") {
-        heapSort();
-    }
-    else if (m_algorithmName == "Counting Sort") {
-        countingSort();
-    }
-    else if (m_algorithmName == "Shell Sort") {
-        shellSort();
-    }
-    else if (m_algorithmName == "Radix Sort") {
-        radixSort();
-    }
-    else if (m_algorithmName == "Bucket Sort") {
-        bucketSort();
-    }
-    else if (m_algorithmName == "Intro Sort") {
-        introSort(); // Simplified version
-    }
-    else {
-        qWarning() << "Worker" << m_chartIndex << ": Unknown algorithm" << m_algorithmName;
-    }
-}
-
-//////////////////////////
-// Bubble Sort
-//////////////////////////
-void Worker::bubbleSort()
-{
-    int n = m_data.size();
-    if (n < 2) {
-        emit progress(m_chartIndex, m_data);
-        return;
-    }
-
-    // Delay multiplier for O(n²) algorithms
-    int speed = m_speed.loadAcquire();
-    speed = qBound(1, speed, 100);
-    int baseDelay = 101 - speed; // Ensures baseDelay >=1
-    int delay = baseDelay * 3; // Longer delay for O(n²)
-
-    for (int i = 0; i < n - 1 && !QThread::currentThread()->isInterruptionRequested(); ++i) {
-        bool swapped = false;
-        for (int j = 0; j < n - i - 1 && !QThread::currentThread()->isInterruptionRequested(); ++j) {
-            if (m_data[j] > m_data[j + 1]) {
-                qSwap(m_data[j], m_data[j + 1]);
-                swapped = true;
-
-                emit progress(m_chartIndex, m_data);
-
-                QThread::msleep(delay);
-            }
+public:
+    StepObserver(Worker &worker, int stepCost)
+        : m_worker(worker), m_token(*worker.m_job.token), m_stepCost(stepCost)
+    {
+    }
+
+    void compare(int i, int j) { m_worker.m_counts.compare(i, j); m_worker.pushStep(SortStep::Compare, i, j); }
+    void swap(int i, int j) { m_worker.m_counts.swap(i, j); m_worker.pushStep(SortStep::Swap, i, j); }
+    template <typename T>
+    void write(int i, const T &value) { m_worker.m_counts.write(i, value); m_worker.pushStep(SortStep::Write, i, sorting::barHeight(value)); }
+    void range(int low, int high) { m_worker.pushStep(SortStep::Range, low, high); }
+    void owner(int low, int high, int thread) { m_worker.pushStep(SortStep::Range, low, high, quint8(thread + 1)); }
+
+    void pace()
+    {
+        if (m_worker.m_lane.spend(m_stepCost) && !m_token.isPaused()) {
+            return;
         }
-        if (!swapped) break;
-    }
-    // Emit final progress signal
-    emit progress(m_chartIndex, m_data);
-}
 
-//////////////////////////
-// Selection Sort
-//////////////////////////
-void Worker::selectionSort()
-{
-    int n = m_data.size();
-    if (n < 2) {
-        emit progress(m_chartIndex, m_data);
-        return;
+        // Make the steps visible before waiting for the next tick or for resume
+        m_worker.flushSteps();
+        QElapsedTimer waited;
+        waited.start();
+        m_worker.m_lane.wait([this]() { return cancelled(); });
+        m_token.checkpoint();
+        m_worker.m_waitNs += waited.nsecsElapsed();
     }
 
-    int speed = m_speed.loadAcquire();
-    speed = qBound(1, speed, 100);
-    int baseDelay = 101 - speed; // Ensures baseDelay >=1
-    int delay = baseDelay * 4; // Longer delay for O(n²)
-
-    for (int i = 0; i < n - 1 && !QThread::currentThread()->isInterruptionRequested(); ++i) {
-        int min_idx = i;
-        for (int j = i + 1; j < n && !QThread::currentThread()->isInterruptionRequested(); ++j) {
-            if (m_data[j] < m_data[min_idx]) {
-                min_idx = j;
-            }
-        }
-
-        if (min_idx != i) {
-            qSwap(m_data[i], m_data[min_idx]);
+    // Parallel sorts call this from pool threads; a relaxed load, safe without the observer lock
+    bool cancelled() const { return m_token.isCancelled(); }
 
-            emit progress(m_chartIndex, m_data);
+private:
+    Worker &m_worker;
+    RunToken &m_token;
+    int m_stepCost; // Budget one visible step uses up
+};
 
-            QThread::msleep(delay);
-        }
-    }
-    // Emit final progress signal
-    emit progress(m_chartIndex, m_data);
-}
-
-//////////////////////////
-// Insertion Sort
-//////////////////////////
-void Worker::insertionSort()
+// Records a trace at full speed, pausing and stopping with the run token
+template <typename Sink>
+class Worker::RecordObserver : public TraceRecorder<Sink>
 {
-    int n = m_data.size();
-    if (n < 2) {
-        emit progress(m_chartIndex, m_data);
-        return;
-    }
-
-    int speed = m_speed.loadAcquire();
-    speed = qBound(1, speed, 100);
-    int baseDelay = 101 - speed; // Ensures baseDelay >=1
-    int delay = baseDelay * 4; // Longer delay for O(n²)
-
-    for (int i = 1; i < n && !QThread::currentThread()->isInterruptionRequested(); ++i) {
-        int key = m_data[i];
-        int j = i - 1;
-
-        while (j >= 0 && m_data[j] > key && !QThread::currentThread()->isInterruptionRequested()) {
-            m_data[j + 1] = m_data[j];
-            j--;
-
-            emit progress(m_chartIndex, m_data);
-
-            QThread::msleep(delay);
+public:
+    RecordObserver(Worker &worker, Sink &sink)
+        : TraceRecorder<Sink>(sink), m_worker(worker), m_token(*worker.m_job.token)
+    {
+    }
+
+    void compare(int i, int j) { m_worker.m_counts.compare(i, j); }
+    void swap(int i, int j) { m_worker.m_counts.swap(i, j); TraceRecorder<Sink>::swap(i, j); }
+    template <typename T>
+    void write(int i, const T &value) { m_worker.m_counts.write(i, value); TraceRecorder<Sink>::write(i, sorting::barHeight(value)); }
+
+    // Nothing to wait for between steps, so only publish and look at the token every so often
+    void pace()
+    {
+        if (--m_untilCheckpoint == 0) {
+            m_untilCheckpoint = CheckpointInterval;
+            m_worker.publishCounters();
+            QElapsedTimer waited;
+            waited.start();
+            m_token.checkpoint();
+            m_worker.m_waitNs += waited.nsecsElapsed();
         }
-        m_data[j + 1] = key;
-
-        emit progress(m_chartIndex, m_data);
-
-        QThread::msleep(delay);
     }
-    // Emit final progress signal
-    emit progress(m_chartIndex, m_data);
-}
 
-//////////////////////////
-// Merge Sort
-//////////////////////////
-void Worker::mergeSort()
-{
-    int n = m_data.size();
-    if (n < 2) {
-        emit progress(m_chartIndex, m_data);
-        return;
-    }
+    bool cancelled() const { return m_token.isCancelled(); }
 
-    mergeSortRecursive(0, n - 1);
-    // Emit final progress signal
-    emit progress(m_chartIndex, m_data);
-}
-
-void Worker::mergeSortRecursive(int left, int right)
-{
-    if (left >= right || QThread::currentThread()->isInterruptionRequested()) {
-        return;
-    }
-
-    int mid = left + (right - left) / 2;
-    mergeSortRecursive(left, mid);
-    mergeSortRecursive(mid + 1, right);
+private:
+    static constexpr int CheckpointInterval = 4096;
 
-    // Merge two halves
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
+    Worker &m_worker;
+    RunToken &m_token;
+    int m_untilCheckpoint = CheckpointInterval;
+};
 
-    QVector<int> L(n1);
-    QVector<int> R(n2);
-
-    for (int i = 0; i < n1; ++i)
-        L[i] = m_data[left + i];
-    for (int j = 0; j < n2; ++j)
-        R[j] = m_data[mid + 1 + j];
-
-    int i = 0, j = 0, k = left;
-
-    int speed = m_speed.loadAcquire();
-    speed = qBound(1, speed, 100);
-    int baseDelay = 101 - speed; // Ensures baseDelay >=1
-    int delay = baseDelay * 2; // Medium delay for O(n log n)
-
-    while (i < n1 && j < n2 && !QThread::currentThread()->isInterruptionRequested()) {
-        if (L[i] <= R[j]) {
-            m_data[k] = L[i];
-            i++;
-        }
-        else {
-            m_data[k] = R[j];
-            j++;
-        }
-        k++;
-
-        emit progress(m_chartIndex, m_data);
-
-        QThread::msleep(delay);
-    }
-
-    while (i < n1 && !QThread::currentThread()->isInterruptionRequested()) {
-        m_data[k++] = L[i++];
-    }
-
-    while (j < n2 && !QThread::currentThread()->isInterruptionRequested()) {
-        m_data[k++] = R[j++];
-    }
-}
-
-//////////////////////////
-// Quick Sort
-//////////////////////////
-void Worker::quickSort()
+Worker::Worker(QObject *parent)
+    : QObject(parent)
 {
-    int n = m_data.size();
-    if (n < 2) {
-        emit progress(m_chartIndex, m_data);
-        return;
-    }
-
-    quickSortRecursive(0, n - 1);
-    // Emit final progress signal
-    emit progress(m_chartIndex, m_data);
+    setSpeed(50);
 }
 
-void Worker::quickSortRecursive(int low, int high)
+void Worker::start(const SortJob &job)
 {
-    if (low < high && !QThread::currentThread()->isInterruptionRequested()) {
-        int pi = partition(low, high);
-
-        emit progress(m_chartIndex, m_data);
-
-        int speed = m_speed.loadAcquire();
-        speed = qBound(1, speed, 100);
-        int baseDelay = 101 - speed; // Ensures baseDelay >=1
-        int delay = baseDelay * 2; // Medium delay for O(n log n)
-
-        QThread::msleep(delay);
-
-        quickSortRecursive(low, pi - 1);
-        quickSortRecursive(pi + 1, high);
-    }
+    // The Worker is idle on its thread, the job reaches it through the event queue
+    QMetaObject::invokeMethod(this, [this, job]() { process(job); }, Qt::QueuedConnection);
 }
 
-int Worker::partition(int low, int high)
+void Worker::setSpeed(int speed)
 {
-    int pivot = m_data[high];
-    int i = low - 1;
-
-    for (int j = low; j <= high - 1 && !QThread::currentThread()->isInterruptionRequested(); j++) {
-        if (m_data[j] < pivot) {
-            i++;
-            qSwap(m_data[i], m_data[j]);
-        }
-    }
-    qSwap(m_data[i + 1], m_data[high]);
-    return (i + 1);
+    m_lane.setRate(PacingScheduler::stepsPerSecond(qBound(1, speed, 100)));
 }
 
-//////////////////////////
-// Heap Sort
-//////////////////////////
-void Worker::heapSort()
+void Worker::process(const SortJob &job)
 {
-    int n = m_data.size();
-    if (n < 2) {
-        emit progress(m_chartIndex, m_data);
-        return;
-    }
-
-    // Build heap
-    for (int i = n / 2 - 1; i >= 0 && !QThread::currentThread()->isInterruptionRequested(); i--) {
-        heapify(n, i);
-    }
-
-    int speed = m_speed.loadAcquire();
-    speed = qBound(1, speed, 100);
-    int baseDelay = 101 - speed; // Ensures baseDelay >=1
-    int delay = baseDelay * 2; // Medium delay for O(n log n)
-
-    // One by one extract elements
-    for (int i = n - 1; i > 0 && !QThread::currentThread()->isInterruptionRequested(); i--) {
-        qSwap(m_data[0], m_data[i]);
-
-        emit progress(m_chartIndex, m_data);
-
-        QThread::msleep(delay);
-
-        heapify(i, 0);
-    }
-    // Emit final progress signal
-    emit progress(m_chartIndex, m_data);
+    m_job = job;
+    m_algorithmName = (job.algorithm < SortAlgorithm::Count) ? QString(sortAlgorithmInfo(job.algorithm).name) : QString();
+    qDebug() << "Worker" << m_job.chartIndex << ": Starting process with algorithm" << m_algorithmName;
+
+    m_waitNs = 0;
+    m_emitNs = 0;
+    m_runClock.start();
+    m_cpuStartNs = sorting::threadCpuTimeNs();
+    sorting::SortArena::threadLocal().resetPeak();
+
+    bool known = false;
+    sorting::visitElementType(m_job.elementType, [this, &known](auto tag) {
+        known = runTyped<typename decltype(tag)::Type>();
+    });
+    publishCounters();
+    if (!known) {
+        qWarning() << "Worker" << m_job.chartIndex << ": Unknown algorithm" << m_algorithmName;
+    }
+
+    // Drop the references to the input and the run's shared state before going idle
+    m_job.data = QVector<int>();
+    m_job.token.reset();
+    m_job.counters.reset();
+    emit finished();
+    qDebug() << "Worker: Finished process";
 }
 
-void Worker::heapify(int n, int i)
+template <typename T>
+bool Worker::runTyped()
 {
-    int largest = i; // Initialize largest as root
-    int l = 2 * i + 1; // left = 2*i + 1
-    int r = 2 * i + 2; // right = 2*i + 2
-
-    // If left child exists and is greater than root
-    if (l < n && m_data[l] > m_data[largest]) {
-        largest = l;
-    }
-
-    // If right child exists and is greater than largest so far
-    if (r < n && m_data[r] > m_data[largest]) {
-        largest = r;
-    }
-
-    // If largest is not root
-    if (largest != i) {
-        qSwap(m_data[i], m_data[largest]);
-
-        heapify(n, largest);
-    }
+    // Build the elements in the buffer of the previous run of this type, it only grows when
+    // the input does
+    std::vector<T> &data = std::get<std::vector<T>>(m_buffers);
+    const int n = int(m_job.data.size());
+    data.resize(n);
+    for (int i = 0; i < n; ++i) {
+        data[i] = sorting::ElementTraits<T>::makeElement(m_job.data[i], i);
+    }
+
+    m_counts = sorting::CountingObserver(sizeof(T));
+    m_job.counters->dataBytes.store((long long)n * sizeof(T), std::memory_order_relaxed);
+    return m_job.recordOnly ? runRecorded(data.data(), n) : runLive(data.data(), n);
 }
 
-//////////////////////////
-// Counting Sort
-//////////////////////////
-void Worker::countingSort()
+template <typename T>
+bool Worker::runLive(T *data, int n)
 {
-    int n = m_data.size();
-    if (n < 2) {
-        emit progress(m_chartIndex, m_data);
-        return;
-    }
-
-    int max = *std::max_element(m_data.begin(), m_data.end());
-    int min = *std::min_element(m_data.begin(), m_data.end());
-    int range = max - min + 1;
-
-    QVector<int> count(range, 0);
-    QVector<int> output(n);
-
-    for (int i = 0; i < n && !QThread::currentThread()->isInterruptionRequested(); i++) {
-        count[m_data[i] - min]++;
-    }
-
-    for (int i = 1; i < range && !QThread::currentThread()->isInterruptionRequested(); i++) {
-        count[i] += count[i - 1];
-    }
-
-    int speed = m_speed.loadAcquire();
-    speed = qBound(1, speed, 100);
-    int baseDelay = 101 - speed; // Ensures baseDelay >=1
-    int delay = baseDelay * 1; // Shorter delay for O(n)
-
-    for (int i = n - 1; i >= 0 && !QThread::currentThread()->isInterruptionRequested(); i--) {
-        output[count[m_data[i] - min] - 1] = m_data[i];
-        count[m_data[i] - min]--;
-
-        emit progress(m_chartIndex, output);
-
-        QThread::msleep(delay);
+    m_pendingSteps.reserve(StepBatchSize);
+    if (m_job.algorithm >= SortAlgorithm::Count) {
+        return false;
     }
 
-    m_data = output;
-    // Emit final progress signal
-    emit progress(m_chartIndex, m_data);
+    StepObserver observer(*this, sortAlgorithmInfo(m_job.algorithm).stepCost);
+    bool known = runSortAlgorithm(m_job.algorithm, data, n, observer);
+    flushSteps();
+    return known;
 }
 
-//////////////////////////
-// Shell Sort
-//////////////////////////
-void Worker::shellSort()
+template <typename T>
+bool Worker::runRecorded(T *data, int n)
 {
-    int n = m_data.size();
-    if (n < 2) {
-        emit progress(m_chartIndex, m_data);
-        return;
+    if (!m_job.traceFilePath.isEmpty()) {
+        return runRecordedToFile(data, n);
     }
 
-    int speed = m_speed.loadAcquire();
-    speed = qBound(1, speed, 100);
-    int baseDelay = 101 - speed; // Ensures baseDelay >=1
-    int delay = baseDelay * 3; // Intermediate delay for Shell Sort
-
-    for (int gap = n / 2; gap > 0 && !QThread::currentThread()->isInterruptionRequested(); gap /= 2) {
-        for (int i = gap; i < n && !QThread::currentThread()->isInterruptionRequested(); i++) {
-            int temp = m_data[i];
-            int j;
-            for (j = i; j >= gap && m_data[j - gap] > temp && !QThread::currentThread()->isInterruptionRequested(); j -= gap) {
-                m_data[j] = m_data[j - gap];
-
-                emit progress(m_chartIndex, m_data);
+    // The job's input is the same array and already shared, so the trace needs no copy of its own
+    QSharedPointer<SortTrace> trace = QSharedPointer<SortTrace>::create(m_algorithmName, m_job.data);
+    RecordObserver<SortTrace> observer(*this, *trace);
+    bool known = runSortAlgorithm(m_job.algorithm, data, n, observer);
 
-                QThread::msleep(delay);
-            }
-            m_data[j] = temp;
-
-            emit progress(m_chartIndex, m_data);
-        }
+    // A cancelled recording is incomplete, don't offer it for playback
+    if (known && !m_job.token->isCancelled()) {
+        emit traceReady(m_job.chartIndex, trace);
     }
-    // Emit final progress signal
-    emit progress(m_chartIndex, m_data);
+    return known;
 }
 
-//////////////////////////
-// Radix Sort
-//////////////////////////
-void Worker::radixSort()
+template <typename T>
+bool Worker::runRecordedToFile(T *data, int n)
 {
-    int n = m_data.size();
-    if (n < 2) {
-        emit progress(m_chartIndex, m_data);
-        return;
-    }
-
-    int max = *std::max_element(m_data.begin(), m_data.end());
-
-    int speed = m_speed.loadAcquire();
-    speed = qBound(1, speed, 100);
-    int baseDelay = 101 - speed; // Ensures baseDelay >=1
-    int delay = baseDelay * 1; // Shorter delay for O(n)
-
-    for (int exp = 1; max / exp > 0 && !QThread::currentThread()->isInterruptionRequested(); exp *= 10) {
-        QVector<int> output(n);
-        QVector<int> count(10, 0);
-
-        for (int i = 0; i < n && !QThread::currentThread()->isInterruptionRequested(); i++) {
-            count[(m_data[i] / exp) % 10]++;
+    // The input values are the bar heights of the unsorted elements
+    TraceFileWriter writer;
+    if (!writer.open(m_job.traceFilePath, m_algorithmName, m_job.seed, m_job.data)) {
+        // Nothing is sorted yet, so the run can still be recorded in memory instead
+        qWarning() << "Worker" << m_job.chartIndex << ": Cannot write trace" << m_job.traceFilePath << writer.errorString()
+                   << "- recording in memory";
+        m_job.traceFilePath.clear();
+        return runRecorded(data, n);
+    }
+
+    RecordObserver<TraceFileWriter> observer(*this, writer);
+    bool known = runSortAlgorithm(m_job.algorithm, data, n, observer);
+    if (!writer.close()) {
+        qWarning() << "Worker" << m_job.chartIndex << ": Failed writing trace" << m_job.traceFilePath;
+        return known;
+    }
+
+    // Play back straight from the mapped file instead of holding the steps in memory
+    if (known && !m_job.token->isCancelled()) {
+        QString error;
+        QSharedPointer<TraceFile> trace = TraceFile::open(m_job.traceFilePath, &error);
+        if (trace) {
+            emit traceReady(m_job.chartIndex, trace);
         }
-
-        for (int i = 1; i < 10 && !QThread::currentThread()->isInterruptionRequested(); i++) {
-            count[i] += count[i - 1];
-        }
-
-        for (int i = n - 1; i >= 0 && !QThread::currentThread()->isInterruptionRequested(); i--) {
-            output[count[(m_data[i] / exp) % 10] - 1] = m_data[i];
-            count[(m_data[i] / exp) % 10]--;
-
-            emit progress(m_chartIndex, output);
-
-            QThread::msleep(delay);
+        else {
+            qWarning() << "Worker" << m_job.chartIndex << ": Cannot open trace" << m_job.traceFilePath << error;
         }
-
-        m_data = output;
     }
-    // Emit final progress signal
-    emit progress(m_chartIndex, m_data);
+    return known;
 }
 
-//////////////////////////
-// Bucket Sort
-//////////////////////////
-void Worker::bucketSort()
+void Worker::pushStep(SortStep::Kind kind, int a, int b, quint8 owner)
 {
-    int n = m_data.size();
-    if (n <= 0) {
-        emit progress(m_chartIndex, m_data);
-        return;
-    }
-
-    int minValue = *std::min_element(m_data.begin(), m_data.end());
-    int maxValue = *std::max_element(m_data.begin(), m_data.end());
-
-    int bucketCount = n / 10; // Adjust bucket count as needed
-    bucketCount = qMax(bucketCount, 1);
-    QVector<QVector<int>> buckets(bucketCount);
-
-    // Distribute input data into buckets
-    for (int i = 0; i < n && !QThread::currentThread()->isInterruptionRequested(); ++i) {
-        int bucketIndex;
-        if (maxValue == minValue) {
-            bucketIndex = 0; // All elements are identical; assign to the first bucket
-        }
-        else {
-            bucketIndex = ((m_data[i] - minValue) * (bucketCount - 1)) / (maxValue - minValue);
-        }
-        buckets[bucketIndex].append(m_data[i]);
-
-        // Optional: Debugging statement
-        // qDebug() << "Bucket Sort - Element:" << m_data[i] << "Bucket Index:" << bucketIndex;
+    m_pendingSteps.append(SortStep{kind, a, b, owner});
+    if (m_pendingSteps.size() >= StepBatchSize) {
+        flushSteps();
     }
-
-    int index = 0;
-
-    int speed = m_speed.loadAcquire();
-    speed = qBound(1, speed, 100);
-    int baseDelay = 101 - speed; // Ensures baseDelay >=1
-    int delay = baseDelay * 1; // Shorter delay for O(n)
-
-    for (int i = 0; i < bucketCount && !QThread::currentThread()->isInterruptionRequested(); ++i) {
-        std::sort(buckets[i].begin(), buckets[i].end());
-
-        for (int j = 0; j < buckets[i].size(); ++j) {
-            m_data[index++] = buckets[i][j];
-
-            emit progress(m_chartIndex, m_data);
-
-            QThread::msleep(delay);
-        }
-    }
-    // Emit final progress signal
-    emit progress(m_chartIndex, m_data);
 }
 
-//////////////////////////
-// Intro Sort (Simplified)
-//////////////////////////
-void Worker::introSort()
+void Worker::flushSteps()
 {
-    int n = m_data.size();
-    if (n < 2) {
-        emit progress(m_chartIndex, m_data);
+    if (m_pendingSteps.isEmpty()) {
         return;
     }
+    publishCounters();
 
-    int maxDepth = 2 * log(n);
-    introSortRecursive(0, n - 1, maxDepth);
-    // Emit final progress signal
-    emit progress(m_chartIndex, m_data);
+    // Hand the batch over and start a fresh one, so the queued copy never has to detach
+    QVector<SortStep> batch;
+    batch.reserve(StepBatchSize);
+    batch.swap(m_pendingSteps);
+
+    // Queued emission copies the arguments into an event; with a busy GUI thread this adds up
+    QElapsedTimer emitting;
+    emitting.start();
+    emit steps(m_job.chartIndex, batch);
+    m_emitNs += emitting.nsecsElapsed();
 }
 
-void Worker::introSortRecursive(int low, int high, int depthLimit)
+void Worker::publishCounters()
 {
-    if (low < high && !QThread::currentThread()->isInterruptionRequested()) {
-        if (depthLimit == 0) {
-            heapSort();
-            return;
-        }
-
-        int pi = partition(low, high);
-
-        emit progress(m_chartIndex, m_data);
-
-        int speed = m_speed.loadAcquire();
-        speed = qBound(1, speed, 100);
-        int baseDelay = 101 - speed; // Ensures baseDelay >=1
-        int delay = baseDelay * 2; // Medium delay for O(n log n)
-        QThread::msleep(delay);
-
-        introSortRecursive(low, pi - 1, depthLimit - 1);
-        introSortRecursive(pi + 1, high, depthLimit - 1);
+    sorting::SortCounters &counters = *m_job.counters;
+    counters.publish(m_counts);
+    counters.wallNs.store(m_runClock.nsecsElapsed(), std::memory_order_relaxed);
+    counters.waitNs.store(m_waitNs, std::memory_order_relaxed);
+    counters.emitNs.store(m_emitNs, std::memory_order_relaxed);
+
+    // CPU time and scratch memory belong to the worker's own thread; parallel sorts also get
+    // here from pool threads, which leave them alone
+    if (QThread::currentThread() == thread()) {
+        counters.cpuNs.store(sorting::threadCpuTimeNs() - m_cpuStartNs, std::memory_order_relaxed);
+        counters.auxBytes.store((long long)sorting::SortArena::threadLocal().peakUsage(), std::memory_order_relaxed);
     }
 }
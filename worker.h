@@ -3,10 +3,43 @@
 
 #include <QObject>
 #include <QVector>
-#include <QAtomicInteger>
 #include <QString>
-#include <cmath> // For log function
+#include <QSharedPointer>
+#include <QElapsedTimer>
+#include <tuple>
+#include <vector>
+#include "sortstep.h"
+#include "sorttrace.h"
+#include "sortalgorithms.h"
+#include "sortelements.h"
+#include "pacingscheduler.h"
+#include "runtoken.h"
+#include "sortcounters.h"
 
+// One sorting run, handed to a Worker by value
+struct SortJob
+{
+    int chartIndex = -1;
+    SortAlgorithm algorithm = SortAlgorithm::Count;
+    QVector<int> data; // Input, left untouched: the Worker sorts its own copy
+    // What the Worker builds from data and sorts; steps and traces carry the bar heights
+    sorting::ElementType elementType = sorting::ElementType::Int32;
+    // Sort at full speed into a trace for later playback instead of streaming paced steps
+    bool recordOnly = false;
+    // In record mode, stream the trace to this file instead of keeping it in memory
+    QString traceFilePath;
+    quint64 seed = 0;
+
+    // Cancels, pauses and resumes the run from any thread; copies of the job share it
+    QSharedPointer<RunToken> token = QSharedPointer<RunToken>::create();
+    // Operation counts, timings and scratch memory of the run, updated while it goes
+    QSharedPointer<sorting::SortCounters> counters = QSharedPointer<sorting::SortCounters>::create();
+};
+
+// Runs sorting jobs one after another on its thread and streams the steps to the GUI.
+// The algorithms live in sortkernels.h; the Worker only adapts them to Qt. Workers are kept
+// by WorkerPool for the lifetime of the application, so the sort buffer, the step batches
+// and the thread's SortArena are all reused from one run to the next.
 class Worker : public QObject
 {
     Q_OBJECT
@@ -14,47 +47,52 @@ class Worker : public QObject
 public:
     explicit Worker(QObject *parent = nullptr);
 
-    // Set the data and algorithm to use
-    void setData(const QVector<int> &data);
-    void setAlgorithm(const QString &algorithmName);
-    void setChartIndex(int index);
+    // Queues the job on the Worker's thread; finished() follows when it is done or cancelled
+    void start(const SortJob &job);
+    // Speed slider position, see PacingScheduler::stepsPerSecond(). Safe to call while sorting.
     void setSpeed(int speed);
 
 signals:
-    void progress(int chartIndex, const QVector<int> &data);
+    // Batch of deltas to apply to the chart's copy of the array
+    void steps(int chartIndex, const QVector<SortStep> &steps);
+    void traceReady(int chartIndex, const QSharedPointer<TraceSource> &trace);
     void finished();
 
-public slots:
-    void process();
-
 private:
-    QVector<int> m_data;
-    QString m_algorithmName;
-    int m_chartIndex;
-    QAtomicInteger<int> m_speed;
-
-    void runAlgorithm();
-
-    // Sorting algorithms
-    void bubbleSort();
-    void selectionSort();
-    void insertionSort();
-    void mergeSort();
-    void quickSort();
-    void heapSort();
-    void countingSort();
-    void shellSort();
-    void radixSort();
-    void bucketSort();
-    void introSort();    // Simplified version
-
-    // Helper functions for complex sorts
-    void mergeSortRecursive(int left, int right);
-    void quickSortRecursive(int low, int high);
-    int partition(int low, int high); // Corrected declaration
-    void heapify(int n, int i);
-    void introSortRecursive(int low, int high, int depthLimit);
+    SortJob m_job; // Current run, only touched on the Worker's thread
+    // Sort buffers, one per element type, each keeping its capacity between runs
+    std::tuple<std::vector<int>, std::vector<long long>, std::vector<float>, std::vector<double>,
+               std::vector<sorting::Record>, std::vector<sorting::WideRecord>> m_buffers;
+    QString m_algorithmName; // Stored in traces
+    PacingScheduler::Lane m_lane; // Step budget of the live run
+    sorting::CountingObserver m_counts; // Counted by the observers, published into m_job.counters
+    long long m_cpuStartNs = 0;
+    QElapsedTimer m_runClock;
+    qint64 m_waitNs = 0; // Pacing and pause
+    qint64 m_emitNs = 0; // Inside emit steps()
+
+    // Steps not yet sent to the GUI thread
+    QVector<SortStep> m_pendingSteps;
+    static constexpr int StepBatchSize = 512;
+
+    // Observers handed to the sorting kernels, defined in worker.cpp
+    class StepObserver;
+    template <typename Sink>
+    class RecordObserver;
+
+    void process(const SortJob &job);
+    template <typename T>
+    bool runTyped();
+    template <typename T>
+    bool runLive(T *data, int n);
+    template <typename T>
+    bool runRecorded(T *data, int n);
+    template <typename T>
+    bool runRecordedToFile(T *data, int n);
 
+    void pushStep(SortStep::Kind kind, int a, int b, quint8 owner = 0);
+    void flushSteps();
+    void publishCounters();
 };
 
 #endif // WORKER_H
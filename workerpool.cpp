@@ -0,0 +1,44 @@
+#include "workerpool.h"
+
+WorkerPool::WorkerPool(int size, QObject *parent) : QObject(parent)
+{
+    if (size <= 0) {
+        size = qMax(1, QThread::idealThreadCount());
+    }
+
+    for (int i = 0; i < size; ++i) {
+        QThread *thread = new QThread(this);
+        thread->setObjectName(QString("Sort worker %1").arg(i));
+
+        // No parent: the Worker lives on its thread and is deleted with the pool
+        Worker *worker = new Worker;
+        worker->moveToThread(thread);
+
+        connect(worker, &Worker::finished, this, [this, worker]() {
+            m_idle.append(worker);
+            emit workerFinished(worker);
+        });
+
+        m_threads.append(thread);
+        m_workers.append(worker);
+        m_idle.append(worker);
+        thread->start();
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    // Running jobs have to be cancelled by their owners first, their tokens are not kept here
+    for (QThread *thread : std::as_const(m_threads)) {
+        thread->quit();
+    }
+    for (QThread *thread : std::as_const(m_threads)) {
+        thread->wait();
+    }
+    qDeleteAll(m_workers);
+}
+
+Worker *WorkerPool::acquire()
+{
+    return m_idle.isEmpty() ? nullptr : m_idle.takeLast();
+}
@@ -0,0 +1,40 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <QObject>
+#include <QVector>
+#include <QThread>
+#include "worker.h"
+
+// Sorting threads created once at startup, each with one Worker that runs a job at a time.
+// Start hands a job to an idle Worker; reset only cancels the running jobs, and each Worker
+// comes back to the pool on its own once it notices. Nothing is created or destroyed per run
+// and the GUI thread never waits for a sorting thread, except when the pool itself goes away.
+class WorkerPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    // size <= 0 uses one thread per hardware thread
+    explicit WorkerPool(int size = 0, QObject *parent = nullptr);
+    ~WorkerPool() override;
+
+    int size() const { return int(m_workers.size()); }
+    int idleCount() const { return int(m_idle.size()); }
+    const QVector<Worker *> &workers() const { return m_workers; }
+
+    // Marks an idle Worker busy and returns it, nullptr when every Worker is busy. The Worker
+    // stays busy until its job finishes, whether it completes or is cancelled.
+    Worker *acquire();
+
+signals:
+    // Emitted once the Worker is idle again, so it can be acquired right away
+    void workerFinished(Worker *worker);
+
+private:
+    QVector<QThread *> m_threads;
+    QVector<Worker *> m_workers;
+    QVector<Worker *> m_idle;
+};
+
+#endif // WORKERPOOL_H
@@ -0,0 +1,152 @@
+#include "workstealingpool.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// Pool and queue index of the current thread, set for pool threads only
+thread_local WorkStealingPool *t_pool = nullptr;
+thread_local int t_index = -1;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(int threadCount)
+{
+    if (threadCount <= 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < threadCount; ++i) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&WorkStealingPool::threadMain, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+}
+
+WorkStealingPool &WorkStealingPool::global()
+{
+    static WorkStealingPool pool;
+    return pool;
+}
+
+int WorkStealingPool::currentThreadIndex()
+{
+    return t_index;
+}
+
+void WorkStealingPool::push(Task task, const TaskGroup *group)
+{
+    // Pool threads keep their own work local, outside threads spread it round-robin
+    const int count = int(m_queues.size());
+    const int index = (t_pool == this) ? t_index : int(m_nextQueue++ % unsigned(count));
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->tasks.push_back({std::move(task), group});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queued++;
+    }
+    m_wake.notify_one();
+}
+
+bool WorkStealingPool::runPendingTask(const TaskGroup *group)
+{
+    Task task;
+    const int count = int(m_queues.size());
+    const int self = (t_pool == this) ? t_index : -1;
+
+    // Own queue first, newest task
+    if (self >= 0) {
+        std::lock_guard<std::mutex> lock(m_queues[self]->mutex);
+        std::deque<Entry> &tasks = m_queues[self]->tasks;
+        for (auto it = tasks.rbegin(); it != tasks.rend(); ++it) {
+            if (!group || it->group == group) {
+                task = std::move(it->task);
+                tasks.erase(std::next(it).base());
+                break;
+            }
+        }
+    }
+
+    // Otherwise steal the oldest task of another thread
+    for (int offset = 1; !task && offset <= count; ++offset) {
+        const int victim = (std::max(self, 0) + offset) % count;
+        if (victim == self) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(m_queues[victim]->mutex);
+        std::deque<Entry> &tasks = m_queues[victim]->tasks;
+        for (auto it = tasks.begin(); it != tasks.end(); ++it) {
+            if (!group || it->group == group) {
+                task = std::move(it->task);
+                tasks.erase(it);
+                break;
+            }
+        }
+    }
+
+    if (!task) {
+        return false;
+    }
+    m_queued--;
+    task();
+    return true;
+}
+
+void WorkStealingPool::threadMain(int index)
+{
+    t_pool = this;
+    t_index = index;
+
+    while (true) {
+        if (runPendingTask()) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() { return m_stopping || m_queued > 0; });
+        if (m_stopping) {
+            return;
+        }
+    }
+}
+
+void WorkStealingPool::TaskGroup::run(Task task)
+{
+    m_pending++;
+    m_pool.push([this, task = std::move(task)]() {
+        task();
+        // Under the lock, so wait() cannot return and destroy the group before we are done
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0) {
+            m_done.notify_all();
+        }
+    }, this);
+}
+
+void WorkStealingPool::TaskGroup::wait()
+{
+    // Run our own queued subtasks, then sleep until the ones other threads took are finished.
+    // Nothing else is picked up: a GUI worker could otherwise end up running another chart's
+    // paced chunk and stall its own run.
+    while (m_pending > 0 && m_pool.runPendingTask(this)) {
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_pending == 0; });
+}
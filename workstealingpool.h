@@ -0,0 +1,82 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fork-join thread pool for the parallel sorting kernels.
+// Every pool thread owns a deque: it pushes and pops its own tasks at the back (newest first,
+// good locality) while idle threads steal from the front of other deques (oldest first, which
+// are the biggest subproblems in divide and conquer). A thread waiting on a TaskGroup runs the
+// group's own queued tasks and then blocks until the rest finish elsewhere; it never picks up
+// unrelated work, which could be another run's paced or paused chunk.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // threadCount <= 0 uses one thread per hardware thread
+    explicit WorkStealingPool(int threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    int threadCount() const { return int(m_threads.size()); }
+
+    // Pool shared by the GUI workers
+    static WorkStealingPool &global();
+    // Index of the pool thread running the caller, -1 outside any pool
+    static int currentThreadIndex();
+
+    // Tasks forked together and joined with wait()
+    class TaskGroup
+    {
+    public:
+        explicit TaskGroup(WorkStealingPool &pool) : m_pool(pool) {}
+        ~TaskGroup() { wait(); }
+
+        void run(Task task);
+        void wait();
+
+    private:
+        WorkStealingPool &m_pool;
+        std::atomic<int> m_pending{0};
+        std::mutex m_mutex;
+        std::condition_variable m_done;
+    };
+
+private:
+    struct Entry
+    {
+        Task task;
+        const TaskGroup *group;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Entry> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<int> m_queued{0};
+    std::atomic<unsigned> m_nextQueue{0};
+    std::atomic<bool> m_stopping{false};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+
+    void push(Task task, const TaskGroup *group);
+    // Runs one queued task, only one of group's when group is set
+    bool runPendingTask(const TaskGroup *group = nullptr);
+    void threadMain(int index);
+};
+
+#endif // WORKSTEALINGPOOL_H